@@ -343,4 +343,112 @@ void EthernetClass::setRetransmissionCount(uint8_t num)
   SPI.endTransaction();
 }
 
+uint16_t EthernetClass::socketTxPointer(uint8_t s)
+{
+  return W5100.readSnTX_WR(s);
+}
+
+void EthernetClass::socketStage(uint8_t s, uint16_t ptr, const uint8_t* buf, uint16_t len)
+{
+  // Same address math as write_data() in socket.cpp, but TX_WR is left for socketCommit()
+  uint16_t off  = ptr & W5100.SMASK;
+  uint16_t dst  = off + W5100.SBASE(s);
+
+  if (W5100.hasOffsetAddressMapping() || (off + len <= W5100.SSIZE))
+  {
+    W5100.write(dst, buf, len);
+  }
+  else
+  {
+    // Wraps around the end of the socket buffer
+    uint16_t size = W5100.SSIZE - off;
+
+    W5100.write(dst, buf, size);
+    W5100.write(W5100.SBASE(s), buf + size, len - size);
+  }
+}
+
+bool EthernetClass::socketCommit(uint8_t s, uint16_t len)
+{
+  SPI.beginTransaction(SPI_ETHERNET_SETTINGS);
+  W5100.writeSnTX_WR(s, W5100.readSnTX_WR(s) + len);
+  W5100.execCmdSn(s, Sock_SEND);
+
+  // Same wait as socketSend()
+  while ( (W5100.readSnIR(s) & SnIR::SEND_OK) != SnIR::SEND_OK )
+  {
+    if (W5100.readSnSR(s) == SnSR::CLOSED)
+    {
+      SPI.endTransaction();
+
+      return false;
+    }
+
+    SPI.endTransaction();
+    yield();
+    SPI.beginTransaction(SPI_ETHERNET_SETTINGS);
+  }
+
+  W5100.writeSnIR(s, SnIR::SEND_OK);
+  SPI.endTransaction();
+
+  return true;
+}
+
+uint16_t EthernetClient::writeStream(uint16_t offset, const uint8_t *buf, uint16_t len)
+{
+  if (sockindex >= MAX_SOCK_NUM)
+    return 0;
+
+  SPI.beginTransaction(SPI_ETHERNET_SETTINGS);
+  Ethernet.socketStage(sockindex, Ethernet.socketTxPointer(sockindex) + offset, buf, len);
+  SPI.endTransaction();
+
+  return len;
+}
+
+uint16_t EthernetClient::writeStream(uint16_t offset, uint16_t len, EthernetWriteProducer producer, void *context)
+{
+  uint8_t  block[ETHERNET_STREAM_BLOCK_SIZE];
+  uint16_t staged = 0;
+
+  if (sockindex >= MAX_SOCK_NUM)
+    return 0;
+
+  // TX_WR doesn't move until writeCommit(), so it's read once and the blocks are placed after it
+  SPI.beginTransaction(SPI_ETHERNET_SETTINGS);
+  uint16_t ptr = Ethernet.socketTxPointer(sockindex) + offset;
+  SPI.endTransaction();
+
+  while (staged < len)
+  {
+    uint16_t n = len - staged;
+
+    if (n > sizeof(block))
+      n = sizeof(block);
+
+    n = producer(block, n, context);
+
+    if (n == 0)
+      break;
+
+    // One transaction per block, as the producer may use the SPI bus, such as for an SD card
+    SPI.beginTransaction(SPI_ETHERNET_SETTINGS);
+    Ethernet.socketStage(sockindex, ptr + staged, block, n);
+    SPI.endTransaction();
+
+    staged += n;
+  }
+
+  return staged;
+}
+
+bool EthernetClient::writeCommit(uint16_t len)
+{
+  if ( (sockindex >= MAX_SOCK_NUM) || (len == 0) )
+    return false;
+
+  return Ethernet.socketCommit(sockindex, len);
+}
+
 EthernetClass Ethernet;
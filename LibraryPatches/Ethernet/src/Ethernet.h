@@ -197,6 +197,11 @@ class EthernetClass
     bool socketSendUDP(uint8_t s);
     // Initialize the "random" source port number
     void socketPortRand(uint16_t n);
+    // Zero-copy TCP send: copy data into the TX buffer at ptr, socketTxPointer() plus the bytes
+    // staged before, without sending it. Then send len staged bytes
+    uint16_t socketTxPointer(uint8_t s);
+    void socketStage(uint8_t s, uint16_t ptr, const uint8_t* buf, uint16_t len);
+    bool socketCommit(uint8_t s, uint16_t len);
 };
 
 extern EthernetClass Ethernet;
@@ -281,6 +286,19 @@ class EthernetUDP : public UDP
 
 
 
+// EthernetClient::writeStream() / writeCommit() are available, checked by FTPClient_Generic
+#define ETHERNET_HAS_WRITE_STREAM       true
+
+// Stack block size used by EthernetClient::writeStream() with a producer. Each block costs one SPI
+// transaction and one frame header (3 bytes on W5500, 4 on W5200) more than a plain write() of
+// the same data, which needs a RAM buffer instead. Raise it if stack allows
+#ifndef ETHERNET_STREAM_BLOCK_SIZE
+  #define ETHERNET_STREAM_BLOCK_SIZE    64
+#endif
+
+// Fills buf with up to len bytes and returns how many, 0 at the end of the data
+typedef uint16_t (*EthernetWriteProducer)(uint8_t *buf, uint16_t len, void *context);
+
 class EthernetClient : public Client
 {
   public:
@@ -331,6 +349,14 @@ class EthernetClient : public Client
       _timeout = timeout;
     }
 
+    // Zero-copy write, without an intermediate RAM buffer. Up to availableForWrite() bytes are staged
+    // straight into the socket TX buffer with writeStream(), offset bytes past the data staged
+    // before, then sent with writeCommit(). The producer is called outside the SPI transaction,
+    // so it can read an SD card on the same SPI bus
+    uint16_t writeStream(uint16_t offset, const uint8_t *buf, uint16_t len);
+    uint16_t writeStream(uint16_t offset, uint16_t len, EthernetWriteProducer producer, void *context);
+    bool writeCommit(uint16_t len);
+
     friend class EthernetServer;
 
     using Print::write;
@@ -132,9 +132,17 @@ uint8_t  W5100Class::ss_pin = SS_PIN_DEFAULT;
 #ifdef ETHERNET_LARGE_BUFFERS
   uint16_t W5100Class::SSIZE = 2048;
   uint16_t W5100Class::SMASK = 0x07FF;
+  bool     W5100Class::sock_sizes = false;
+  uint8_t  W5100Class::buf_sock   = 0;
 #endif
 W5100Class W5100;
 
+W5100Class::DMAStartCallback W5100Class::dma_start      = NULL;
+W5100Class::DMABusyCallback  W5100Class::dma_busy       = NULL;
+W5100Class::DMAIdleCallback  W5100Class::dma_idle       = NULL;
+W5100Class::DMAAbortCallback W5100Class::dma_abort      = NULL;
+uint16_t                     W5100Class::dma_threshold  = W5100_DMA_THRESHOLD;
+
 // pointers and bitmasks for optimized SS pin
 #if defined(__AVR__)
   volatile uint8_t * W5100Class::ss_pin_reg;
@@ -160,6 +168,10 @@ W5100Class W5100;
   volatile uint32_t * W5100Class::ss_pin_reg;
   uint32_t W5100Class::ss_pin_mask;
   #warning w5100.cpp Use __SAMD21G18A__
+#elif defined(ESP32)
+  uint32_t W5100Class::ss_pin_mask;
+#elif defined(ARDUINO_ARCH_RP2040) && !defined(ARDUINO_ARCH_MBED)
+  uint32_t W5100Class::ss_pin_mask;
 #endif
 
 // KH
@@ -245,6 +257,8 @@ uint8_t W5100Class::init(uint8_t socketNumbers, uint8_t new_ss_pin)
   {
     CH_BASE_MSB = 0x10;
 #ifdef ETHERNET_LARGE_BUFFERS
+    sock_sizes = false;
+
 #if MAX_SOCK_NUM <= 1
     SSIZE = 16384;
 #elif MAX_SOCK_NUM <= 2
@@ -329,6 +343,77 @@ uint8_t W5100Class::init(uint8_t socketNumbers, uint8_t new_ss_pin)
   return 1; // successful init
 }
 
+#ifdef ETHERNET_LARGE_BUFFERS
+
+static bool validBufferSize(uint8_t kb)
+{
+  return (kb != 0) && (kb <= 16) && !(kb & (kb - 1));
+}
+
+bool W5100Class::setSocketBufferSizes(const uint8_t *txKB, const uint8_t *rxKB)
+{
+  uint8_t i;
+  uint8_t txTotal = 0;
+  uint8_t rxTotal = 0;
+  uint8_t minTx   = 16;
+  uint8_t maxSize = 0;
+
+  if (chip != 55)
+    return false;
+
+  for (i = 0; i < MAX_SOCK_NUM; i++)
+  {
+    if (!validBufferSize(txKB[i]) || !validBufferSize(rxKB[i]))
+      return false;
+
+    txTotal += txKB[i];
+    rxTotal += rxKB[i];
+
+    if (txKB[i] < minTx)
+      minTx = txKB[i];
+
+    if (txKB[i] > maxSize)
+      maxSize = txKB[i];
+
+    if (rxKB[i] > maxSize)
+      maxSize = rxKB[i];
+  }
+
+  if ( (txTotal > 16) || (rxTotal > 16) )
+    return false;
+
+  SPI.beginTransaction(SPI_ETHERNET_SETTINGS);
+
+  for (i = 0; i < MAX_SOCK_NUM; i++)
+  {
+    writeSnRX_SIZE(i, rxKB[i]);
+    writeSnTX_SIZE(i, txKB[i]);
+  }
+
+  for (; i < 8; i++)
+  {
+    writeSnRX_SIZE(i, 0);
+    writeSnTX_SIZE(i, 0);
+  }
+
+  SPI.endTransaction();
+
+  // socketSend() sends at most SSIZE bytes at a time, so it must fit in the smallest TX buffer.
+  // The W5500 wraps the offset in each socket buffer, so SMASK only has to cover the largest one
+  SSIZE       = (uint16_t) minTx << 10;
+  SMASK       = ((uint16_t) maxSize << 10) - 1;
+  sock_sizes  = true;
+
+#if ( W5100_DEBUG > 0 )
+  Serial.print("W5100::setSocketBufferSizes: SSIZE =");
+  Serial.println(SSIZE);
+#endif
+
+  return true;
+}
+
+#endif
+
 // Soft reset the Wiznet chip, by writing to its MR register reset bit
 uint8_t W5100Class::softReset(void)
 {
@@ -514,20 +599,131 @@ W5100Linkstatus W5100Class::getLinkStatus()
   }
 }
 
+// true to send the W5100 read and write frames byte by byte, as upstream does. The block-framed path
+// (false) hasn't been checked on a real W5100 yet, and the upstream variant of it was never root-caused
+#ifndef W5100_SPI_BYTEWISE_FRAMES
+  #define W5100_SPI_BYTEWISE_FRAMES   true
+#endif
+
+#ifndef SPI_HAS_TRANSFER_BUF
+
+// Staging buffer size for block writes on cores without SPI.transfer(txbuf, rxbuf, len)
+#ifndef W5100_SPI_BLOCK_SIZE
+  #define W5100_SPI_BLOCK_SIZE    32
+#endif
+
+// SPI.transfer(buf, len) overwrites buf with the received bytes, so the data is copied to a
+// stack buffer and sent in blocks, instead of one SPI.transfer() call per byte
+static void spiWriteBlock(const uint8_t *buf, uint16_t len)
+{
+  uint8_t block[W5100_SPI_BLOCK_SIZE];
+
+  while (len > 0)
+  {
+    uint16_t n = (len < sizeof(block)) ? len : sizeof(block);
+
+    memcpy(block, buf, n);
+    SPI.transfer(block, n);
+
+    buf += n;
+    len -= n;
+  }
+}
+
+#endif
+
+// Returns DMA_NOT_USED if the transfer must be done with SPI.transfer() instead. Called with SS low and
+// the SPI transaction open, which both stay so until the DMA transfer is done
+uint8_t W5100Class::transferDMA(const uint8_t *tx, uint8_t *rx, uint16_t len)
+{
+  if ( (dma_start == NULL) || (len < dma_threshold) || !dma_start(tx, rx, len) )
+    return DMA_NOT_USED;
+
+  unsigned long start = millis();
+
+  while (dma_busy())
+  {
+    if (millis() - start > W5100_DMA_TIMEOUT_MS)
+    {
+      // Stop the channel before SPI.transfer() uses the same peripheral, and don't use the backend again
+      if (dma_abort)
+        dma_abort();
+
+      dma_start = NULL;
+
+      return DMA_TIMEOUT;
+    }
+
+    if (dma_idle)
+      dma_idle();
+  }
+
+  return DMA_DONE;
+}
+
+// Sends the cmdLen header bytes of a W5200/W5500 socket buffer frame, SS being low, then its data phase.
+// If the DMA transfer times out, how much of it went through is unknown. The frame is then ended and sent
+// again with SPI.transfer()
+void W5100Class::transferFrame(uint8_t *cmd, uint8_t cmdLen, const uint8_t *tx, uint8_t *rx, uint16_t len)
+{
+  uint8_t header[4];
+
+  // SPI.transfer(cmd, cmdLen) overwrites cmd with the answer
+  memcpy(header, cmd, cmdLen);
+  SPI.transfer(cmd, cmdLen);
+
+  uint8_t dma = transferDMA(tx, rx, len);
+
+  if (dma == DMA_DONE)
+    return;
+
+  if (dma == DMA_TIMEOUT)
+  {
+    resetSS();
+    setSS();
+    SPI.transfer(header, cmdLen);
+  }
+
+  if (tx)
+  {
+#ifdef SPI_HAS_TRANSFER_BUF
+    SPI.transfer(tx, NULL, len);
+#else
+    spiWriteBlock(tx, len);
+#endif
+  }
+  else
+  {
+    memset(rx, 0, len);
+    SPI.transfer(rx, len);
+  }
+}
+
 uint16_t W5100Class::write(uint16_t addr, const uint8_t *buf, uint16_t len)
 {
   uint8_t cmd[8];
 
   if (chip == 51)
   {
+    // The W5100 needs SS high between 4-byte frames, so a run of bytes can't be one transfer.
+    // With W5100_SPI_BYTEWISE_FRAMES false, each frame is sent with one block transfer instead
     for (uint16_t i = 0; i < len; i++)
     {
-      setSS();
-      SPI.transfer(0xF0);
-      SPI.transfer(addr >> 8);
-      SPI.transfer(addr & 0xFF);
+      cmd[0] = 0xF0;
+      cmd[1] = addr >> 8;
+      cmd[2] = addr & 0xFF;
+      cmd[3] = buf[i];
       addr++;
-      SPI.transfer(buf[i]);
+
+      setSS();
+#if W5100_SPI_BYTEWISE_FRAMES
+      SPI.transfer(cmd[0]);
+      SPI.transfer(cmd[1]);
+      SPI.transfer(cmd[2]);
+      SPI.transfer(cmd[3]);
+#else
+      SPI.transfer(cmd, 4);
+#endif
       resetSS();
     }
   }
@@ -538,19 +734,7 @@ uint16_t W5100Class::write(uint16_t addr, const uint8_t *buf, uint16_t len)
     cmd[1] = addr & 0xFF;
     cmd[2] = ((len >> 8) & 0x7F) | 0x80;
     cmd[3] = len & 0xFF;
-    SPI.transfer(cmd, 4);
-
-#ifdef SPI_HAS_TRANSFER_BUF
-    SPI.transfer(buf, NULL, len);
-#else
-
-    // TODO: copy 8 bytes at a time to cmd[] and block transfer
-    for (uint16_t i = 0; i < len; i++)
-    {
-      SPI.transfer(buf[i]);
-    }
-
-#endif
+    transferFrame(cmd, 4, buf, NULL, len);
     resetSS();
   }
   else
@@ -578,6 +762,11 @@ uint16_t W5100Class::write(uint16_t addr, const uint8_t *buf, uint16_t len)
       //  10## #nnn nnnn nnnn
       cmd[0] = addr >> 8;
       cmd[1] = addr & 0xFF;
+#ifdef ETHERNET_LARGE_BUFFERS
+      if (sock_sizes)
+        cmd[2] = (buf_sock << 5) | 0x14;  // setSocketBufferSizes()
+      else
+#endif
 #if defined(ETHERNET_LARGE_BUFFERS) && MAX_SOCK_NUM <= 1
       cmd[2] = 0x14;                       // 16K buffers
 #elif defined(ETHERNET_LARGE_BUFFERS) && MAX_SOCK_NUM <= 2
@@ -593,6 +782,11 @@ uint16_t W5100Class::write(uint16_t addr, const uint8_t *buf, uint16_t len)
       // receive buffers
       cmd[0] = addr >> 8;
       cmd[1] = addr & 0xFF;
+#ifdef ETHERNET_LARGE_BUFFERS
+      if (sock_sizes)
+        cmd[2] = (buf_sock << 5) | 0x1C;  // setSocketBufferSizes()
+      else
+#endif
 #if defined(ETHERNET_LARGE_BUFFERS) && MAX_SOCK_NUM <= 1
       cmd[2] = 0x1C;                       // 16K buffers
 #elif defined(ETHERNET_LARGE_BUFFERS) && MAX_SOCK_NUM <= 2
@@ -615,18 +809,7 @@ uint16_t W5100Class::write(uint16_t addr, const uint8_t *buf, uint16_t len)
     }
     else
     {
-      SPI.transfer(cmd, 3);
-#ifdef SPI_HAS_TRANSFER_BUF
-      SPI.transfer(buf, NULL, len);
-#else
-
-      // TODO: copy 8 bytes at a time to cmd[] and block transfer
-      for (uint16_t i = 0; i < len; i++)
-      {
-        SPI.transfer(buf[i]);
-      }
-
-#endif
+      transferFrame(cmd, 3, buf, NULL, len);
     }
 
     resetSS();
@@ -643,23 +826,26 @@ uint16_t W5100Class::read(uint16_t addr, uint8_t *buf, uint16_t len)
   {
     for (uint16_t i = 0; i < len; i++)
     {
-      setSS();
-#if 1
-      SPI.transfer(0x0F);
-      SPI.transfer(addr >> 8);
-      SPI.transfer(addr & 0xFF);
-      addr++;
-      buf[i] = SPI.transfer(0);
-#else
+      // SPI.transfer(cmd, 4) overwrites cmd with the answer, so the frame is rebuilt every time.
+      // The data byte comes back in the 4th position
       cmd[0] = 0x0F;
       cmd[1] = addr >> 8;
       cmd[2] = addr & 0xFF;
       cmd[3] = 0;
-      SPI.transfer(cmd, 4); // TODO: why doesn't this work?
-      buf[i] = cmd[3];
       addr++;
+
+      setSS();
+#if W5100_SPI_BYTEWISE_FRAMES
+      SPI.transfer(cmd[0]);
+      SPI.transfer(cmd[1]);
+      SPI.transfer(cmd[2]);
+      cmd[3] = SPI.transfer(0);
+#else
+      SPI.transfer(cmd, 4);
 #endif
       resetSS();
+
+      buf[i] = cmd[3];
     }
   }
   else if (chip == 52)
@@ -669,9 +855,7 @@ uint16_t W5100Class::read(uint16_t addr, uint8_t *buf, uint16_t len)
     cmd[1] = addr & 0xFF;
     cmd[2] = (len >> 8) & 0x7F;
     cmd[3] = len & 0xFF;
-    SPI.transfer(cmd, 4);
-    memset(buf, 0, len);
-    SPI.transfer(buf, len);
+    transferFrame(cmd, 4, NULL, buf, len);
     resetSS();
   }
   else
@@ -699,6 +883,11 @@ uint16_t W5100Class::read(uint16_t addr, uint8_t *buf, uint16_t len)
       //  10## #nnn nnnn nnnn
       cmd[0] = addr >> 8;
       cmd[1] = addr & 0xFF;
+#ifdef ETHERNET_LARGE_BUFFERS
+      if (sock_sizes)
+        cmd[2] = (buf_sock << 5) | 0x10;  // setSocketBufferSizes()
+      else
+#endif
 #if defined(ETHERNET_LARGE_BUFFERS) && MAX_SOCK_NUM <= 1
       cmd[2] = 0x10;                       // 16K buffers
 #elif defined(ETHERNET_LARGE_BUFFERS) && MAX_SOCK_NUM <= 2
@@ -714,6 +903,11 @@ uint16_t W5100Class::read(uint16_t addr, uint8_t *buf, uint16_t len)
       // receive buffers
       cmd[0] = addr >> 8;
       cmd[1] = addr & 0xFF;
+#ifdef ETHERNET_LARGE_BUFFERS
+      if (sock_sizes)
+        cmd[2] = (buf_sock << 5) | 0x18;  // setSocketBufferSizes()
+      else
+#endif
 #if defined(ETHERNET_LARGE_BUFFERS) && MAX_SOCK_NUM <= 1
       cmd[2] = 0x18;                       // 16K buffers
 #elif defined(ETHERNET_LARGE_BUFFERS) && MAX_SOCK_NUM <= 2
@@ -725,9 +919,7 @@ uint16_t W5100Class::read(uint16_t addr, uint8_t *buf, uint16_t len)
 #endif
     }
 
-    SPI.transfer(cmd, 3);
-    memset(buf, 0, len);
-    SPI.transfer(buf, len);
+    transferFrame(cmd, 3, NULL, buf, len);
     resetSS();
   }
 
@@ -41,6 +41,13 @@
 #include <Arduino.h>
 #include <SPI.h>
 
+#if defined(ESP32)
+  #include "soc/soc.h"
+  #include "soc/gpio_reg.h"
+#elif defined(ARDUINO_ARCH_RP2040) && !defined(ARDUINO_ARCH_MBED)
+  #include "hardware/structs/sio.h"
+#endif
+
 #ifndef USE_W5100
   #define USE_W5100     false
 #else
@@ -91,6 +98,18 @@
 #endif
 
 
+// Socket buffer transfers of at least this many bytes go through the DMA backend, when one is set
+// with W5100Class::setDMA(). Shorter ones cost less with a plain SPI.transfer()
+#ifndef W5100_DMA_THRESHOLD
+  #define W5100_DMA_THRESHOLD   64
+#endif
+
+// A DMA transfer still busy after this long is stopped with the abort() callback of setDMA(). The DMA
+// backend is then disabled, and the frame is sent again with SPI.transfer()
+#ifndef W5100_DMA_TIMEOUT_MS
+  #define W5100_DMA_TIMEOUT_MS  100
+#endif
+
 typedef uint8_t SOCKET;
 
 class SnMR
@@ -408,6 +427,18 @@ class W5100Class
 #ifdef ETHERNET_LARGE_BUFFERS
     static uint16_t SSIZE;
     static uint16_t SMASK;
+
+    // W5500 only. Sets the TX and RX buffer size of each of the MAX_SOCK_NUM sockets, in KB (1, 2, 4, 8 or 16,
+    // at most 16KB in total for each direction), such as 2KB for the FTP control socket and 8KB for the data socket.
+    // The RX size is also the TCP window. Call after Ethernet.begin(), before opening any socket.
+    // Returns false if the chip isn't a W5500 or the sizes are invalid. Only exists with ETHERNET_LARGE_BUFFERS
+    static bool setSocketBufferSizes(const uint8_t *txKB, const uint8_t *rxKB);
+
+  private:
+    static bool    sock_sizes;
+    static uint8_t buf_sock;
+
+  public:
 #else
     static const uint16_t SSIZE = 2048;
     static const uint16_t SMASK = 0x07FF;
@@ -418,6 +449,16 @@ class W5100Class
       {
         return socknum * SSIZE + 0x4000;
       }
+#ifdef ETHERNET_LARGE_BUFFERS
+      else if (sock_sizes)
+      {
+        // The sockets don't have the same buffer size, so the socket can't be encoded in the
+        // address. It's kept for the following read() / write()
+        buf_sock = socknum;
+
+        return 0x8000;
+      }
+#endif
       else
       {
         return socknum * SSIZE + 0x8000;
@@ -430,6 +471,15 @@ class W5100Class
       {
         return socknum * SSIZE + 0x6000;
       }
+#ifdef ETHERNET_LARGE_BUFFERS
+      else if (sock_sizes)
+      {
+        // Same as SBASE()
+        buf_sock = socknum;
+
+        return 0xC000;
+      }
+#endif
       else
       {
         return socknum * SSIZE + 0xC000;
@@ -449,6 +499,46 @@ class W5100Class
       ss_pin = pin;
     }
 
+    // Optional DMA backend for the W5200/W5500 socket buffer transfers, such as Adafruit_ZeroDMA on SAMD51,
+    // HAL_SPI_TransmitReceive_DMA() on STM32, SPI.transferAsync() on RP2040 or the EventResponder
+    // SPI.transfer() on Teensy 4.x. start() begins a transfer of len bytes (tx or rx may be NULL, send 0s
+    // when tx is NULL) and returns false to fall back to SPI.transfer(). busy() returns true until it's done.
+    // abort() must stop a transfer still busy after W5100_DMA_TIMEOUT_MS and release the SPI peripheral,
+    // which is then used by SPI.transfer(). While waiting, idle() is called, if set, so the application can
+    // prepare its next chunk
+    typedef bool (*DMAStartCallback)(const uint8_t *tx, uint8_t *rx, uint16_t len);
+    typedef bool (*DMABusyCallback)(void);
+    typedef void (*DMAAbortCallback)(void);
+    typedef void (*DMAIdleCallback)(void);
+
+    static void setDMA(DMAStartCallback start, DMABusyCallback busy, DMAAbortCallback abort,
+                       DMAIdleCallback idle = NULL, uint16_t threshold = W5100_DMA_THRESHOLD)
+    {
+      dma_start     = start;
+      dma_busy      = busy;
+      dma_abort     = abort;
+      dma_idle      = idle;
+      dma_threshold = threshold;
+    }
+
+  private:
+    static DMAStartCallback dma_start;
+    static DMABusyCallback  dma_busy;
+    static DMAAbortCallback dma_abort;
+    static DMAIdleCallback  dma_idle;
+    static uint16_t         dma_threshold;
+
+    // Result of transferDMA()
+    enum
+    {
+      DMA_NOT_USED = 0,     // send with SPI.transfer() instead
+      DMA_DONE,
+      DMA_TIMEOUT           // aborted, frame state unknown : end it and send it again
+    };
+
+    static uint8_t transferDMA(const uint8_t *tx, uint8_t *rx, uint16_t len);
+    static void transferFrame(uint8_t *cmd, uint8_t cmdLen, const uint8_t *tx, uint8_t *rx, uint16_t len);
+
   private:
 #if defined(__AVR__)
 
@@ -627,6 +717,58 @@ class W5100Class
     {
       *(ss_pin_reg + 6) = ss_pin_mask;
     }
+#elif defined(ESP32)
+
+#warning Use ESP32 architecture
+
+    static uint32_t ss_pin_mask;
+
+    inline static void initSS()
+    {
+      // Set / clear registers for GPIO0-31, digitalWrite() for the others
+      ss_pin_mask = (ss_pin < 32) ? (1UL << ss_pin) : 0;
+      pinMode(ss_pin, OUTPUT);
+    }
+
+    inline static void setSS()
+    {
+      if (ss_pin_mask)
+        REG_WRITE(GPIO_OUT_W1TC_REG, ss_pin_mask);
+      else
+        digitalWrite(ss_pin, LOW);
+    }
+
+    inline static void resetSS()
+    {
+      if (ss_pin_mask)
+        REG_WRITE(GPIO_OUT_W1TS_REG, ss_pin_mask);
+      else
+        digitalWrite(ss_pin, HIGH);
+    }
+
+#elif defined(ARDUINO_ARCH_RP2040) && !defined(ARDUINO_ARCH_MBED)
+
+#warning Use RP2040 architecture
+
+    static uint32_t ss_pin_mask;
+
+    // arduino-pico pin numbers are GPIO numbers
+    inline static void initSS()
+    {
+      ss_pin_mask = 1UL << ss_pin;
+      pinMode(ss_pin, OUTPUT);
+    }
+
+    inline static void setSS()
+    {
+      sio_hw->gpio_clr = ss_pin_mask;
+    }
+
+    inline static void resetSS()
+    {
+      sio_hw->gpio_set = ss_pin_mask;
+    }
+
 #else
 
 #warning Use Default architecture
@@ -50,6 +50,13 @@ extern "C"
 #define UIPETHERNET_SENDPACKET 2
 #define UIPETHERNET_BUFFERREAD 4
 
+#define UIPETHERNET_NO_INT_PIN 0xFF
+
+// Max received packets processed by one tick() when the INT pin is used
+#ifndef UIP_RX_DRAIN_MAX
+  #define UIP_RX_DRAIN_MAX     4
+#endif
+
 #define uip_ip_addr(addr, ip) do { \
                      ((u16_t *)(addr))[0] = HTONS(((ip[0]) << 8) | (ip[1])); \
                      ((u16_t *)(addr))[1] = HTONS(((ip[2]) << 8) | (ip[3])); \
@@ -89,6 +96,14 @@ class UIPEthernetClass
 
     void init(const uint8_t pin);
 
+#if defined(ARDUINO)
+    // Optional, call after begin(). ENC28J60 INT pin (active low). This is a poll-skip optimisation, not
+    // interrupt-driven receive : the ISR only sets a flag, and packets are still processed by tick(), i.e.
+    // by maintain() and the UIPClient calls. tick() then skips the SPI poll of the chip when nothing was
+    // signalled, and processes up to UIP_RX_DRAIN_MAX packets instead of one when something was
+    void setInterruptPin(const uint8_t pin);
+#endif
+
     int begin(const uint8_t* mac);
     void begin(const uint8_t* mac, IPAddress ip);
     void begin(const uint8_t* mac, IPAddress ip, IPAddress dns);
@@ -133,10 +148,18 @@ class UIPEthernetClass
 #endif
     static unsigned long periodic_timer;
 
+#if defined(ARDUINO)
+    static uint8_t int_pin;
+    static volatile bool rx_pending;
+
+    static void rxISR(void);
+#endif
+
     static void netInit(const uint8_t* mac);
     static void configure(IPAddress ip, IPAddress dns, IPAddress gateway, IPAddress subnet);
 
     static void tick();
+    static bool processPacket();
 
     static bool network_send();
 
@@ -27,6 +27,7 @@
 #include "UIPEthernet.h"
 #include "utility/logging.h"
 #include "utility/Enc28J60Network.h"
+#include "utility/chksum.h"
 
 #include "UIPUdp.h"
 
@@ -47,6 +48,17 @@ uint8_t UIPEthernetClass::packetstate(0);
 
 unsigned long UIPEthernetClass::periodic_timer;
 
+#if defined(ARDUINO)
+  uint8_t UIPEthernetClass::int_pin(UIPETHERNET_NO_INT_PIN);
+  volatile bool UIPEthernetClass::rx_pending(false);
+#endif
+
+#if defined(ESP8266) || defined(ESP32)
+  #define UIP_ISR_ATTR IRAM_ATTR
+#else
+  #define UIP_ISR_ATTR
+#endif
+
 IPAddress UIPEthernetClass::_dnsServerAddress;
 #if UIP_UDP
   DhcpClass* UIPEthernetClass::_dhcp(NULL);
@@ -65,6 +77,24 @@ void UIPEthernetClass::init(const uint8_t pin)
   ENC28J60ControlCS = pin;
 }
 
+#if defined(ARDUINO)
+void UIPEthernetClass::setInterruptPin(const uint8_t pin)
+{
+  // Enc28J60Network::init() already enables EIE.INTIE | EIE.PKTIE
+  int_pin = pin;
+  rx_pending = true;
+
+  pinMode(int_pin, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(int_pin), rxISR, FALLING);
+}
+
+// The SPI bus may be in use by the sketch and uIP isn't reentrant, so the chip is only read later, from tick()
+void UIP_ISR_ATTR UIPEthernetClass::rxISR(void)
+{
+  rx_pending = true;
+}
+#endif
+
 #if UIP_UDP
 int
 UIPEthernetClass::begin(const uint8_t* mac)
@@ -272,70 +302,30 @@ UIPEthernetClass::tick()
   wdt_reset();
 #endif
 
-  if (in_packet == NOBLOCK)
-  {
-    in_packet = Enc28J60Network::receivePacket();
-#if ACTLOGLEVEL>=LOG_DEBUG
-
-    if (in_packet != NOBLOCK)
-    {
-      LogObject.uart_send_str(F("UIPEthernetClass::tick() DEBUG:receivePacket: "));
-      LogObject.uart_send_decln(in_packet);
-    }
+#if defined(ARDUINO)
 
-#endif
+  if (int_pin == UIPETHERNET_NO_INT_PIN)
+  {
+    processPacket();
   }
-
-  if (in_packet != NOBLOCK)
+  else if ( (in_packet != NOBLOCK) || rx_pending || ((long)( millis() - periodic_timer ) >= 0) )
   {
-    packetstate = UIPETHERNET_FREEPACKET;
-    uip_len = Enc28J60Network::blockSize(in_packet);
+    // The periodic check catches an INT edge lost to the PKTIF erratum.
+    // Bounded, so that a burst can't starve the connection timers below
+    uint8_t i;
 
-    if (uip_len > 0)
-    {
-      Enc28J60Network::readPacket(in_packet, 0, (uint8_t*)uip_buf, UIP_BUFSIZE);
+    rx_pending = false;
 
-      if (ETH_HDR ->type == HTONS(UIP_ETHTYPE_IP))
-      {
-        uip_packet = in_packet; //required for upper_layer_checksum of in_packet!
-#if ACTLOGLEVEL>=LOG_DEBUG
-        LogObject.uart_send_str(F("UIPEthernetClass::tick() DEBUG:readPacket type IP, uip_len: "));
-        LogObject.uart_send_decln(uip_len);
-#endif
-        uip_arp_ipin();
-        uip_input();
+    for (i = 0; (i < UIP_RX_DRAIN_MAX) && processPacket(); i++)
+      ;
 
-        if (uip_len > 0)
-        {
-          uip_arp_out();
-          network_send();
-        }
-      }
-      else if (ETH_HDR ->type == HTONS(UIP_ETHTYPE_ARP))
-      {
-#if ACTLOGLEVEL>=LOG_DEBUG
-        LogObject.uart_send_str(F("UIPEthernetClass::tick() DEBUG:readPacket type ARP, uip_len: "));
-        LogObject.uart_send_decln(uip_len);
-#endif
-        uip_arp_arpin();
-
-        if (uip_len > 0)
-        {
-          network_send();
-        }
-      }
-    }
+    if (i == UIP_RX_DRAIN_MAX)
+      rx_pending = true;
+  }
 
-    if (in_packet != NOBLOCK && (packetstate & UIPETHERNET_FREEPACKET))
-    {
-#if ACTLOGLEVEL>=LOG_DEBUG
-      LogObject.uart_send_str(F("UIPEthernetClass::tick() DEBUG:freeing packet: "));
-      LogObject.uart_send_decln(in_packet);
+#else
+  processPacket();
 #endif
-      Enc28J60Network::freePacket();
-      in_packet = NOBLOCK;
-    }
-  }
 
   unsigned long now = millis();
 
@@ -520,47 +510,91 @@ void UIPEthernetClass::configure(IPAddress ip, IPAddress dns, IPAddress gateway,
 
 UIPEthernetClass UIPEthernet;
 
-/*---------------------------------------------------------------------------*/
-uint16_t
-UIPEthernetClass::chksum(uint16_t sum, const uint8_t *data, uint16_t len)
+// Reads and processes the next received packet, if any. Returns true if one was processed and freed,
+// false if there was none or it's still held by a client whose buffers are full
+bool
+UIPEthernetClass::processPacket()
 {
-#if ACTLOGLEVEL>=LOG_DEBUG_V3
-  LogObject.uart_send_strln(
-    F("UIPEthernetClass::chksum(uint16_t sum, const uint8_t *data, uint16_t len) DEBUG_V3:Function started"));
-#endif
-  uint16_t t;
-  const uint8_t *dataptr;
-  const uint8_t *last_byte;
-
-  dataptr = data;
-  last_byte = data + len - 1;
-
-  while (dataptr < last_byte)   /* At least two more bytes */
+  if (in_packet == NOBLOCK)
   {
-    t = (dataptr[0] << 8) + dataptr[1];
-    sum += t;
+    in_packet = Enc28J60Network::receivePacket();
+#if ACTLOGLEVEL>=LOG_DEBUG
 
-    if (sum < t)
+    if (in_packet != NOBLOCK)
     {
-      sum++;            /* carry */
+      LogObject.uart_send_str(F("UIPEthernetClass::processPacket() DEBUG:receivePacket: "));
+      LogObject.uart_send_decln(in_packet);
     }
 
-    dataptr += 2;
+#endif
   }
 
-  if (dataptr == last_byte)
+  if (in_packet != NOBLOCK)
   {
-    t = (dataptr[0] << 8) + 0;
-    sum += t;
+    packetstate = UIPETHERNET_FREEPACKET;
+    uip_len = Enc28J60Network::blockSize(in_packet);
+
+    if (uip_len > 0)
+    {
+      Enc28J60Network::readPacket(in_packet, 0, (uint8_t*)uip_buf, UIP_BUFSIZE);
+
+      if (ETH_HDR ->type == HTONS(UIP_ETHTYPE_IP))
+      {
+        uip_packet = in_packet; //required for upper_layer_checksum of in_packet!
+#if ACTLOGLEVEL>=LOG_DEBUG
+        LogObject.uart_send_str(F("UIPEthernetClass::processPacket() DEBUG:readPacket type IP, uip_len: "));
+        LogObject.uart_send_decln(uip_len);
+#endif
+        uip_arp_ipin();
+        uip_input();
+
+        if (uip_len > 0)
+        {
+          uip_arp_out();
+          network_send();
+        }
+      }
+      else if (ETH_HDR ->type == HTONS(UIP_ETHTYPE_ARP))
+      {
+#if ACTLOGLEVEL>=LOG_DEBUG
+        LogObject.uart_send_str(F("UIPEthernetClass::processPacket() DEBUG:readPacket type ARP, uip_len: "));
+        LogObject.uart_send_decln(uip_len);
+#endif
+        uip_arp_arpin();
 
-    if (sum < t)
+        if (uip_len > 0)
+        {
+          network_send();
+        }
+      }
+    }
+
+    if (in_packet != NOBLOCK && (packetstate & UIPETHERNET_FREEPACKET))
     {
-      sum++;            /* carry */
+#if ACTLOGLEVEL>=LOG_DEBUG
+      LogObject.uart_send_str(F("UIPEthernetClass::processPacket() DEBUG:freeing packet: "));
+      LogObject.uart_send_decln(in_packet);
+#endif
+      Enc28J60Network::freePacket();
+      in_packet = NOBLOCK;
+
+      return true;
     }
   }
 
+  return false;
+}
+
+/*---------------------------------------------------------------------------*/
+uint16_t
+UIPEthernetClass::chksum(uint16_t sum, const uint8_t *data, uint16_t len)
+{
+#if ACTLOGLEVEL>=LOG_DEBUG_V3
+  LogObject.uart_send_strln(
+    F("UIPEthernetClass::chksum(uint16_t sum, const uint8_t *data, uint16_t len) DEBUG_V3:Function started"));
+#endif
   /* Return sum in host byte order. */
-  return sum;
+  return uip_chksum_words(sum, data, len);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -972,6 +972,38 @@ Enc28J60Network::writeOp(uint8_t op, uint8_t address, uint8_t data)
 #endif
 }
 
+// true to move buffer memory byte by byte, for a core whose SPI.transfer(buf, len) doesn't work
+#ifndef ENC28J60_SPI_BYTEWISE
+  #define ENC28J60_SPI_BYTEWISE   false
+#endif
+
+#if ENC28J60_USE_SPILIB && !ENC28J60_SPI_BYTEWISE && defined(ARDUINO) && !defined(SPI_HAS_TRANSFER_BUF)
+
+// Staging buffer size for block writes on cores without SPI.transfer(txbuf, rxbuf, len)
+#ifndef ENC28J60_SPI_BLOCK_SIZE
+  #define ENC28J60_SPI_BLOCK_SIZE   32
+#endif
+
+// SPI.transfer(buf, len) overwrites buf with the received bytes, and the packet buffer belongs to
+// the caller, so the data is copied to a stack buffer and sent in blocks
+static void spiWriteBlock(const uint8_t* data, uint16_t len)
+{
+  uint8_t block[ENC28J60_SPI_BLOCK_SIZE];
+
+  while (len > 0)
+  {
+    uint16_t n = (len < sizeof(block)) ? len : sizeof(block);
+
+    memcpy(block, data, n);
+    SPI.transfer(block, n);
+
+    data += n;
+    len  -= n;
+  }
+}
+
+#endif
+
 void
 Enc28J60Network::readBuffer(uint16_t len, uint8_t* data)
 {
@@ -992,10 +1024,21 @@ Enc28J60Network::readBuffer(uint16_t len, uint8_t* data)
   waitspi();
 #endif
 
+  // read data
+#if ENC28J60_USE_SPILIB && !ENC28J60_SPI_BYTEWISE
+#if defined(ARDUINO)
+  // The ENC28J60 ignores SI during RBM, so the buffer is simply clocked in as one block
+  memset(data, 0, len);
+  SPI.transfer(data, len);
+#endif
+#if defined(__MBED__)
+  _spi.write(NULL, 0, (char*) data, len);
+#endif
+#else
+
   while (len)
   {
     len--;
-    // read data
 #if ENC28J60_USE_SPILIB
 #if defined(ARDUINO)
     *data = SPI.transfer(0x00);
@@ -1011,6 +1054,8 @@ Enc28J60Network::readBuffer(uint16_t len, uint8_t* data)
     data++;
   }
 
+#endif
+
   //*data='\0';
   CSPASSIVE;
 }
@@ -1035,10 +1080,23 @@ Enc28J60Network::writeBuffer(uint16_t len, uint8_t* data)
   waitspi();
 #endif
 
+  // write data
+#if ENC28J60_USE_SPILIB && !ENC28J60_SPI_BYTEWISE
+#if defined(ARDUINO)
+#ifdef SPI_HAS_TRANSFER_BUF
+  SPI.transfer(data, NULL, len);
+#else
+  spiWriteBlock(data, len);
+#endif
+#endif
+#if defined(__MBED__)
+  _spi.write((const char*) data, len, NULL, 0);
+#endif
+#else
+
   while (len)
   {
     len--;
-    // write data
 #if ENC28J60_USE_SPILIB
 #if defined(ARDUINO)
     SPI.transfer(*data);
@@ -1054,6 +1112,8 @@ Enc28J60Network::writeBuffer(uint16_t len, uint8_t* data)
 #endif
   }
 
+#endif
+
   CSPASSIVE;
 }
 
@@ -1182,6 +1242,26 @@ Enc28J60Network::clkout(uint8_t clk)
   writeReg(ECOCON, clk & 0x7);
 }
 
+// true to compute the checksums with the on-chip DMA checksum engine, instead of reading the data
+// back over SPI. Off by default : per the ENC28J60 errata, packets received while the DMA computes
+// a checksum can be lost or corrupted, and during uploads that is when the ACKs arrive. Reception is
+// therefore paused (ECON1.RXEN) while the DMA runs, so a packet arriving then is dropped cleanly and
+// retransmitted by its sender, instead of being corrupted
+#ifndef ENC28J60_HW_CHECKSUM
+  #define ENC28J60_HW_CHECKSUM      false
+#endif
+
+// Shorter ranges are cheaper to read back than to set up the DMA for
+#ifndef ENC28J60_HW_CHECKSUM_MIN
+  #define ENC28J60_HW_CHECKSUM_MIN  32
+#endif
+
+// ECON1 reads before a DMA checksum still running is given up, and the software sum used instead.
+// A full frame takes a few microseconds, much less than this many SPI reads
+#ifndef ENC28J60_HW_CHECKSUM_MAX_POLLS
+  #define ENC28J60_HW_CHECKSUM_MAX_POLLS  1000
+#endif
+
 uint16_t
 Enc28J60Network::chksum(uint16_t sum, memhandle handle, memaddress pos, uint16_t len)
 {
@@ -1190,6 +1270,68 @@ Enc28J60Network::chksum(uint16_t sum, memhandle handle, memaddress pos, uint16_t
     F("Enc28J60Network::chksum(uint16_t sum, memhandle handle, memaddress pos, uint16_t len) DEBUG_V3:Function started"));
 #endif
   uint16_t t;
+
+#if ENC28J60_HW_CHECKSUM
+  memblock *packet = handle == UIP_RECEIVEBUFFERHANDLE ? &receivePkt : &blocks[handle];
+
+  if (len > packet->size - pos)
+    len = packet->size - pos;
+
+  if (len >= ENC28J60_HW_CHECKSUM_MIN)
+  {
+    memaddress start = handle == UIP_RECEIVEBUFFERHANDLE
+                       && packet->begin + pos > RXSTOP_INIT ? packet->begin + pos - RXSTOP_INIT + RXSTART_INIT : packet->begin + pos;
+    memaddress end = start + len - 1;
+
+    // the DMA wraps at the end of the receive buffer by itself
+    if ((handle == UIP_RECEIVEBUFFERHANDLE) && (start <= RXSTOP_INIT) && (end > RXSTOP_INIT))
+      end -= ((RXSTOP_INIT + 1) - RXSTART_INIT);
+
+    writeRegPair(EDMASTL, start);
+    writeRegPair(EDMANDL, end);
+
+    // errata : no reception while the DMA computes the checksum
+    bool rxEnabled = readOp(ENC28J60_READ_CTRL_REG, ECON1) & ECON1_RXEN;
+
+    if (rxEnabled)
+      writeOp(ENC28J60_BIT_FIELD_CLR, ECON1, ECON1_RXEN);
+
+    writeOp(ENC28J60_BIT_FIELD_SET, ECON1, ECON1_CSUMEN);
+    writeOp(ENC28J60_BIT_FIELD_SET, ECON1, ECON1_DMAST);
+
+    uint16_t polls = 0;
+
+    while ( (readOp(ENC28J60_READ_CTRL_REG, ECON1) & ECON1_DMAST) && (++polls < ENC28J60_HW_CHECKSUM_MAX_POLLS) )
+      ;
+
+    bool done = (polls < ENC28J60_HW_CHECKSUM_MAX_POLLS);
+
+    if (!done)
+      writeOp(ENC28J60_BIT_FIELD_CLR, ECON1, ECON1_DMAST);
+
+    writeOp(ENC28J60_BIT_FIELD_CLR, ECON1, ECON1_CSUMEN);
+
+    if (rxEnabled)
+      writeOp(ENC28J60_BIT_FIELD_SET, ECON1, ECON1_RXEN);
+
+    if (done)
+    {
+      // EDMACS holds the complemented sum of the big-endian words, odd byte padded with 0 as below
+      t = ~((readReg(EDMACSH) << 8) | readReg(EDMACSL));
+      sum += t;
+
+      if (sum < t)
+      {
+        sum++;            /* carry */
+      }
+
+      return sum;
+    }
+
+    // DMA stuck, fall back to reading the data
+  }
+
+#endif
   len = setReadPtr(handle, pos, len) - 1;
   CSACTIVE;
   // issue read command
@@ -0,0 +1,149 @@
+/*
+  chksum.h - word-at-a-time Internet checksum of UIPEthernetClass::chksum().
+  Copyright (c) 2013 Norbert Truchsess <norbert.truchsess@t-online.de>
+  All rights reserved.
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef UIPETHERNET_CHKSUM_H_
+#define UIPETHERNET_CHKSUM_H_
+
+#include <stdint.h>
+#include <string.h>
+
+/* 1 to sum native 32-bit words (32-bit CPUs), 0 for big-endian 16-bit words (8/16-bit CPUs) */
+#ifndef UIP_CHKSUM_WIDE_WORDS
+  #if (UINTPTR_MAX > 0xFFFF) && defined(__BYTE_ORDER__)
+    #define UIP_CHKSUM_WIDE_WORDS   1
+  #else
+    #define UIP_CHKSUM_WIDE_WORDS   0
+  #endif
+#endif
+
+/* Adds the one's complement sum of the big-endian 16-bit words of data to sum, the odd byte
+   padded with 0. Kept apart from UIPEthernet.cpp so that it can be tested on the host. */
+static inline uint16_t
+uip_chksum_words(uint16_t sum, const uint8_t *data, uint16_t len)
+{
+#if UIP_CHKSUM_WIDE_WORDS
+  /* 32-bit CPU: add native 32-bit words into a 64-bit accumulator (ADDS / ADC) and fold the
+     carries once at the end. The one's complement sum doesn't depend on the byte order (RFC 1071),
+     so on a little-endian CPU the bytes of the result are just swapped back. memcpy() keeps
+     unaligned data safe, and compiles to a single load where the CPU allows it. */
+  uint64_t acc = 0;
+  uint32_t w;
+
+  while (len >= 16)
+  {
+    memcpy(&w, data, 4);
+    acc += w;
+    memcpy(&w, data + 4, 4);
+    acc += w;
+    memcpy(&w, data + 8, 4);
+    acc += w;
+    memcpy(&w, data + 12, 4);
+    acc += w;
+
+    data += 16;
+    len -= 16;
+  }
+
+  while (len >= 4)
+  {
+    memcpy(&w, data, 4);
+    acc += w;
+
+    data += 4;
+    len -= 4;
+  }
+
+  if (len >= 2)
+  {
+    uint16_t h;
+
+    memcpy(&h, data, 2);
+    acc += h;
+
+    data += 2;
+    len -= 2;
+  }
+
+  if (len)
+  {
+    /* odd byte, padded with 0 */
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    acc += data[0];
+#else
+    acc += (uint16_t) data[0] << 8;
+#endif
+  }
+
+  acc = (acc & 0xFFFFFFFF) + (acc >> 32);
+  acc = (acc & 0xFFFFFFFF) + (acc >> 32);
+  acc = (acc & 0xFFFF) + (acc >> 16);
+  acc = (acc & 0xFFFF) + (acc >> 16);
+  acc = (acc & 0xFFFF) + (acc >> 16);
+
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+  acc = ((acc & 0xFF) << 8) | (acc >> 8);
+#endif
+
+  uint16_t t = (uint16_t) acc;
+#else
+  /* 8/16-bit CPU: add the big-endian words into a 32-bit accumulator without a carry test
+     per word. len <= 65535, so it can't overflow before the final fold. */
+  uint32_t acc = 0;
+
+  while (len >= 8)
+  {
+    acc += ((uint16_t) data[0] << 8) | data[1];
+    acc += ((uint16_t) data[2] << 8) | data[3];
+    acc += ((uint16_t) data[4] << 8) | data[5];
+    acc += ((uint16_t) data[6] << 8) | data[7];
+
+    data += 8;
+    len -= 8;
+  }
+
+  while (len >= 2)
+  {
+    acc += ((uint16_t) data[0] << 8) | data[1];
+
+    data += 2;
+    len -= 2;
+  }
+
+  if (len)
+  {
+    acc += (uint16_t) data[0] << 8;
+  }
+
+  acc = (acc & 0xFFFF) + (acc >> 16);
+  acc = (acc & 0xFFFF) + (acc >> 16);
+
+  uint16_t t = (uint16_t) acc;
+#endif
+
+  sum += t;
+
+  if (sum < t)
+  {
+    sum++;            /* carry */
+  }
+
+  return sum;
+}
+
+#endif /* UIPETHERNET_CHKSUM_H_ */
@@ -12,13 +12,13 @@
 
 // This is the GitHub Octocat in HEX in order to test the FTP Upload
 
-#if (ESP32 || ESP8266)
-  #define USING_PROGMEM     PROGMEM
-#else
-  #define USING_PROGMEM
+// Always in flash : WriteData_P() reads it with memcpy_P on AVR and ESP8266. PROGMEM is empty on
+// cores with a flat address space
+#ifndef PROGMEM
+  #define PROGMEM
 #endif
 
-unsigned char octocat_pic[] USING_PROGMEM =
+const unsigned char octocat_pic[] PROGMEM =
 {
   0xFF, 0xD8, 0xFF, 0xE1, 0x00, 0x18, 0x45, 0x78, 0x69, 0x66, 0x00, 0x00, 0x49, 0x49, 0x2A, 0x00,
   0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xEC, 0x00, 0x11,
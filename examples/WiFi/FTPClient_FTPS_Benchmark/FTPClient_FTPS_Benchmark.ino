@@ -0,0 +1,141 @@
+/******************************************************************************
+  FTPClient_FTPS_Benchmark.ino
+
+  FTP Client for Generic boards using SD, FS, etc.
+
+  Based on and modified from
+
+  1) esp32_ftpclient Library         https://github.com/ldab/ESP32_FTPClient
+
+  Built by Khoi Hoang https://github.com/khoih-prog/FTPClient_Generic
+******************************************************************************/
+
+// Upload throughput over FTPS against the size of the chunks given to the TLS client (setWriteChunkSize()).
+// Each chunk ends at least one TLS record, so bigger chunks mean fewer records, MACs and IVs per MB, up to
+// the TLS library output buffer :
+// - RP2040W : FTP_TLS_TX_BUFFER_SIZE (16KB + 85 by default), so all chunk sizes below change the record size
+// - ESP8266 : FTP_TLS_TX_BUFFER_SIZE (4KB + 85 by default, to save heap), so chunks above 4KB are sent in 4KB records
+// - ESP32 : CONFIG_MBEDTLS_SSL_OUT_CONTENT_LEN, 4KB in arduino-esp32. Chunks above 4KB are still sent in 4KB records,
+//   and only measure the cost of write() calls
+// On ESP32, the AES / SHA accelerators are used by mbedTLS when CONFIG_MBEDTLS_HARDWARE_AES / _SHA are set,
+// which is the default of the Arduino core
+
+#include "Arduino.h"
+
+#include "defines.h"
+
+#include <FTPClient_Generic.h>
+
+// Change according to your FTP server. vsftpd with `ssl_enable=YES`, plus `implicit_ssl=YES` for ESP8266 / RP2040W
+char ftp_server[] = "192.168.2.112";
+
+char ftp_user[]   = "ftp_test";
+char ftp_pass[]   = "ftp_test";
+
+char dirName[]    = "/home/ftp_test";
+
+#if (ESP32)
+  FTPClient_Generic ftp (ftp_server, ftp_user, ftp_pass, 60000);
+#else
+  FTPClient_Generic ftp (ftp_server, FTPS_IMPLICIT_PORT, ftp_user, ftp_pass, 60000);
+#endif
+
+#define TEST_BUFFER_SIZE      16384
+#define TEST_FILE_SIZE        (512 * 1024UL)
+
+uint8_t testBuffer[TEST_BUFFER_SIZE];
+
+const size_t chunkSizes[] = { 1024, 2048, 4096, 8192, 16384 };
+
+void runTest(size_t chunkSize)
+{
+  ftp.setWriteChunkSize(chunkSize);
+
+  ftp.InitFile(COMMAND_XFER_TYPE_BINARY);
+  ftp.NewFile("ftps_benchmark.bin");
+
+  unsigned long start = millis();
+  uint32_t      sent  = 0;
+
+  while (sent < TEST_FILE_SIZE)
+  {
+    FtpResult res = ftp.WriteData(testBuffer, TEST_BUFFER_SIZE);
+
+    sent += res.bytes;
+
+    if (!res)
+      break;
+  }
+
+  FtpResult res = ftp.CloseFile();
+
+  unsigned long elapsed = millis() - start;
+
+  Serial.print(F("Chunk = "));
+  Serial.print(chunkSize);
+  Serial.print(F(" bytes, sent = "));
+  Serial.print(sent);
+  Serial.print(F(", time = "));
+  Serial.print(elapsed);
+  Serial.print(F(" ms, speed = "));
+  Serial.print( (elapsed > 0) ? ( (float) sent / 1048.576f / elapsed ) : 0.0f, 3);
+  Serial.println(res ? F(" MB/s") : F(" MB/s, FAILED"));
+}
+
+void setup()
+{
+  Serial.begin( 115200 );
+
+  while (!Serial && millis() < 5000);
+
+  delay(500);
+
+  Serial.print(F("\nStarting FTPClient_FTPS_Benchmark on "));
+  Serial.print(BOARD_NAME);
+  Serial.print(F(" with "));
+  Serial.println(SHIELD_TYPE);
+  Serial.println(FTPCLIENT_GENERIC_VERSION);
+
+  WiFi.begin( WIFI_SSID, WIFI_PASS );
+
+  Serial.print("Connecting WiFi, SSID = ");
+  Serial.println(WIFI_SSID);
+
+  while (WiFi.status() != WL_CONNECTED)
+  {
+    delay(500);
+    Serial.print(".");
+  }
+
+  Serial.print("\nIP address: ");
+  Serial.println(WiFi.localIP());
+
+  for (size_t i = 0; i < TEST_BUFFER_SIZE; i++)
+    testBuffer[i] = (uint8_t) i;
+
+  // Test only. Use setCACert() / setTrustAnchors() with the server root CA
+#if (ESP32)
+  ftp.setCACert(NULL);
+#else
+  ftp.setTrustAnchors(NULL);
+#endif
+
+  if (!ftp.OpenConnection())
+  {
+    Serial.println(F("Can't connect to the FTPS server"));
+
+    return;
+  }
+
+  ftp.ChangeWorkDir(dirName);
+
+  for (size_t i = 0; i < sizeof(chunkSizes) / sizeof(chunkSizes[0]); i++)
+    runTest(chunkSizes[i]);
+
+  ftp.DeleteFile("ftps_benchmark.bin");
+  ftp.CloseConnection();
+}
+
+void loop()
+{
+}
@@ -0,0 +1,62 @@
+/****************************************************************************************************************************
+  defines.h
+
+  FTP Client for Generic boards using SD, FS, etc.
+
+  Based on and modified from
+
+  1) esp32_ftpclient Library         https://github.com/ldab/ESP32_FTPClient
+
+  Built by Khoi Hoang https://github.com/khoih-prog/FTPClient_Generic
+ ***************************************************************************************************************************************/
+
+#ifndef defines_h
+#define defines_h
+
+#define DEBUG_WIFI_WEBSERVER_PORT   Serial
+
+// Debug Level from 0 to 4. Keep low, logging slows down the transfer
+#define _WIFI_LOGLEVEL_             1
+#define _FTP_LOGLEVEL_              1
+
+//////////////////////////////////
+
+#if (ESP32)
+
+  #include <WiFi.h>
+  #define BOARD_TYPE      "ESP32"
+
+#elif (ESP8266)
+
+  #include <ESP8266WiFi.h>
+  #define BOARD_TYPE      "ESP8266"
+
+#elif defined(ARDUINO_RASPBERRY_PI_PICO_W)
+
+  #include <WiFi.h>
+  #define BOARD_TYPE      "RASPBERRY_PI_PICO_W"
+
+#else
+
+  #error FTPS is only supported on ESP32, ESP8266 and RP2040W
+
+#endif
+
+#ifndef BOARD_NAME
+  #if defined(ARDUINO_BOARD)
+    #define BOARD_NAME    ARDUINO_BOARD
+  #else
+    #define BOARD_NAME    BOARD_TYPE
+  #endif
+#endif
+
+#define SHIELD_TYPE           "WiFi with TLS"
+
+//////////////////////////////////
+
+#define FTP_CLIENT_USING_FTPS       true
+
+#define WIFI_SSID      "YOUR_SSID"
+#define WIFI_PASS      "12345678"
+
+#endif    //defines_h
@@ -118,7 +118,7 @@ void setup()
 
   ftp.InitFile(COMMAND_XFER_TYPE_BINARY);
   ftp.NewFile("octocat.jpg");
-  ftp.WriteData( octocat_pic, sizeof(octocat_pic) );
+  ftp.WriteData_P( octocat_pic, sizeof(octocat_pic) );
   ftp.CloseFile();
 
   // Create the file new and write a string into it
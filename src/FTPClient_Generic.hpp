@@ -29,16 +29,124 @@
 #define FTPCLIENT_GENERIC_HPP
 
 #include "FTPClient_Generic_Debug.h"
+#include "FTPClient_Generic_Sink.h"
+#include "FTPClient_Generic_Arena.h"
 
 /////////////////////////////////////////////
 
-#define BUFFER_SIZE       1500
+#ifndef BUFFER_SIZE
+  #define BUFFER_SIZE       1500
+#endif
 
 #define TIMEOUT_MS        10000UL
 
+// Max silence between two data chunks, once the first byte arrived. The first byte waits up to the reply timeout
+#ifndef FTP_DATA_IDLE_TIMEOUT_MS
+  #define FTP_DATA_IDLE_TIMEOUT_MS    5000UL
+#endif
+
+// Max length of a directory listing line. Longer lines are truncated
+#ifndef FTP_LINE_BUFFER_SIZE
+  #define FTP_LINE_BUFFER_SIZE        256
+#endif
+
+// false : build without Arduino `String`, which fragments the heap on AVR, SAMD and ESP8266 in long-running sketches.
+// ContentList(String *) / DownloadString(String &) are then removed. Use the char buffer or line callback versions
+#ifndef FTP_CLIENT_USING_STRING
+  #define FTP_CLIENT_USING_STRING     true
+#endif
+
+// true : the data buffer and listing line buffer are no longer part of each FTPClient_Generic object, but taken
+// from the FTPArena given with setArena() for the duration of each transfer, then given back.
+// Sessions not transferring at the same time can share one arena of FTP_ARENA_SIZE bytes
+#ifndef FTP_CLIENT_USING_ARENA
+  #define FTP_CLIENT_USING_ARENA      false
+#endif
+
+// Arena needed by one transfer, with room for alignment
+#define FTP_ARENA_SIZE                ( BUFFER_SIZE + FTP_LINE_BUFFER_SIZE + 2 * FTP_ARENA_ALIGN )
+
+// Largest chunk given to one client write() during an upload, with FTPS. Each write() ends at least one
+// TLS record, so fewer, larger writes mean fewer records (one MAC and IV each). Upload data is passed
+// straight from the caller's buffer, not copied into clientBuf.
+// Records are also capped by the TLS library output buffer :
+// - ESP8266 / RP2040W (BearSSL) : FTP_TLS_TX_BUFFER_SIZE, set on the data connection with setBufferSizes()
+// - ESP32 (mbedTLS) : CONFIG_MBEDTLS_SSL_OUT_CONTENT_LEN of the core, 4KB in arduino-esp32. Larger chunks
+//   only save write() calls there
+#ifndef FTP_TLS_RECORD_SIZE
+  #define FTP_TLS_RECORD_SIZE         16384
+#endif
+
+// BearSSL output buffer of the data connection (ESP8266, RP2040W). The core default (~0.8KB) would cap
+// each record whatever the chunk size. The 85 bytes are BearSSL's record overhead. Uses this much RAM,
+// plus the 16KB input buffer, while a transfer runs. On ESP8266 the control connection already holds
+// ~17KB, so records are kept at 4KB there
+#ifndef FTP_TLS_TX_BUFFER_SIZE
+  #if defined(ESP8266)
+    #define FTP_TLS_TX_BUFFER_SIZE    ( 4096 + 85 )
+  #else
+    #define FTP_TLS_TX_BUFFER_SIZE    ( FTP_TLS_RECORD_SIZE + 85 )
+  #endif
+#endif
+
+// Bounded retry when the TX buffer is full (client write() accepts 0 byte)
+#ifndef FTP_WRITE_MAX_RETRIES
+  #define FTP_WRITE_MAX_RETRIES       10
+#endif
+
+// Backoff step between write retries. Delay grows linearly with the retry count
+#ifndef FTP_WRITE_RETRY_DELAY_MS
+  #define FTP_WRITE_RETRY_DELAY_MS    5
+#endif
+
+// PASV sent again at most this many times while the reply is neither 227 nor an error, with or without a deadline
+#ifndef FTP_PASV_MAX_RETRIES
+  #define FTP_PASV_MAX_RETRIES        3
+#endif
+
+// Flash not readable through plain pointers (AVR), or only by aligned 32-bit words (ESP8266).
+// WriteData_P() then copies it to RAM with memcpy_P, otherwise hands it to the client directly
+#if ( defined(__AVR__) || ESP8266 )
+  #define FTP_PROGMEM_NEEDS_COPY      true
+#else
+  #define FTP_PROGMEM_NEEDS_COPY      false
+#endif
+
 /////////////////////////////////////////////
 
-#if FTP_CLIENT_USING_QNETHERNET
+// true : FTPS over the platform TLS client, on ESP32, ESP8266 and RP2040W (arduino-pico)
+#ifndef FTP_CLIENT_USING_FTPS
+  #define FTP_CLIENT_USING_FTPS       false
+#endif
+
+// true : WriteData() with a producer streams straight into the W5x00 socket TX buffer, without clientBuf.
+// Needs the patched Ethernet / EthernetLarge library (EthernetClient::writeStream() / writeCommit())
+#ifndef FTP_CLIENT_USING_ZERO_COPY
+  #define FTP_CLIENT_USING_ZERO_COPY  false
+#endif
+
+#if FTP_CLIENT_USING_ZERO_COPY && !FTP_CLIENT_USING_ETHERNET
+  #error FTP_CLIENT_USING_ZERO_COPY needs FTP_CLIENT_USING_ETHERNET and the patched Ethernet library
+#endif
+
+#if FTP_CLIENT_USING_FTPS
+
+  #if !(ESP32 || ESP8266 || ARDUINO_ARCH_RP2040)
+    #error FTPS is only supported on ESP32, ESP8266 and RP2040W
+  #endif
+
+  #include <WiFiClientSecure.h>
+  #define theFTPClient    WiFiClientSecure
+
+  #if (ESP32)
+    // Explicit FTPS : plain connection upgraded with `AUTH TLS` (mbedTLS setPlainStart() / startTLS(), core v3.0+)
+    #define FTP_FTPS_EXPLICIT         true
+  #else
+    // Implicit FTPS (port 990) : BearSSL can't upgrade a plain connection, but its session is reused by the data channel
+    #define FTP_FTPS_EXPLICIT         false
+  #endif
+
+#elif FTP_CLIENT_USING_QNETHERNET
 
   #include <QNEthernetClient.h>
   #define theFTPClient    EthernetClient
@@ -52,6 +160,11 @@
 
   #include <EthernetClient.h>
   #define theFTPClient    EthernetClient
+
+  // Ethernet_Generic and the stock Ethernet library have no writeStream()
+  #if FTP_CLIENT_USING_ZERO_COPY && !defined(ETHERNET_HAS_WRITE_STREAM)
+    #error FTP_CLIENT_USING_ZERO_COPY needs the patched Ethernet / EthernetLarge library of LibraryPatches
+  #endif
   
 #elif FTP_CLIENT_USING_WIFININA
 
@@ -65,11 +178,41 @@
   
 #endif
 
+// true : enable setActiveMode(), for servers whose passive ports are blocked by a firewall
+#ifndef FTP_CLIENT_USING_ACTIVE_MODE
+  #define FTP_CLIENT_USING_ACTIVE_MODE    false
+#endif
+
+#if FTP_CLIENT_USING_ACTIVE_MODE
+
+  #if FTP_CLIENT_USING_FTPS
+    #error Active mode is not supported with FTPS
+  #elif FTP_CLIENT_USING_QNETHERNET
+    #include <QNEthernetServer.h>
+    #define theFTPServer    EthernetServer
+  #elif FTP_CLIENT_USING_NATIVE_ETHERNET
+    #include <NativeEthernetServer.h>
+    #define theFTPServer    EthernetServer
+  #elif FTP_CLIENT_USING_ETHERNET
+    #include <EthernetServer.h>
+    #define theFTPServer    EthernetServer
+  #elif FTP_CLIENT_USING_WIFININA
+    #include <WiFiServer_Generic.h>
+    #define theFTPServer    WiFiServer
+  #else
+    #include <WiFiServer.h>
+    #define theFTPServer    WiFiServer
+  #endif
+
+#endif
+
 /////////////////////////////////////////////
 
 #define FTP_PORT                        21
+#define FTPS_IMPLICIT_PORT              990
 
 #define COMMAND_QUIT                    F("QUIT")
+#define COMMAND_NOOP                    F("NOOP")
 #define COMMAND_USER                    F("USER ")
 #define COMMAND_PASS                    F("PASS ")
 
@@ -77,6 +220,7 @@
 #define COMMAND_RENAME_FILE_TO          F("RNTO ")
 
 #define COMMAND_FILE_LAST_MOD_TIME      F("MDTM ")
+#define COMMAND_FILE_SIZE               F("SIZE ")
 
 #define COMMAND_APPEND_FILE             F("APPE ")
 #define COMMAND_DELETE_FILE             F("DELE ")
@@ -91,13 +235,154 @@
 #define COMMAND_FILE_UPLOAD             F("STOR ")
 
 #define COMMAND_PASSIVE_MODE            F("PASV")
+#define COMMAND_EXTENDED_PASSIVE_MODE   F("EPSV")
+#define COMMAND_FEATURES                F("FEAT")
+#define COMMAND_AUTH_TLS                F("AUTH TLS")
+#define COMMAND_PROTECTION_BUFFER_SIZE  F("PBSZ 0")
+#define COMMAND_DATA_PROTECTION         F("PROT P")
+
+#define COMMAND_ACTIVE_MODE             F("PORT ")
+#define COMMAND_EXTENDED_ACTIVE_MODE    F("EPRT ")
 
 #define COMMAND_XFER_TYPE_ASCII         ("Type A")
 #define COMMAND_XFER_TYPE_BINARY        ("Type I")
 
 /////////////////////////////////////////////
 
+#define FILE_STATUS_OK                  150
+#define COMMAND_OK                      200
+#define AUTH_TLS_OK                     234
+#define FILE_STATUS                     213
+#define FEATURES_LIST                   211
 #define ENTERING_PASSIVE_MODE           227
+#define ENTERING_EXTENDED_PASSIVE_MODE  229
+#define SERVICE_NOT_AVAILABLE           421
+#define DATA_CONNECTION_FAILED          425
+#define COMMAND_NOT_IMPLEMENTED         502
+#define DATA_TLS_REFUSED                522
+
+/////////////////////////////////////////////
+
+typedef enum : uint8_t
+{
+  FTP_STATUS_OK = 0,
+  FTP_STATUS_NOT_CONNECTED,         // not logged in, or connection lost on a previous call
+  FTP_STATUS_CONNECT_FAILED,        // TCP connect of control or data connection failed
+  FTP_STATUS_TIMEOUT,               // no reply within the phase timeout
+  FTP_STATUS_DEADLINE,              // deadline set with setDeadline() expired
+  FTP_STATUS_SERVER_ERROR,          // 4xx / 5xx reply, see code. Only 421 ends the session
+  FTP_STATUS_PROTOCOL_ERROR,        // unexpected or malformed reply, or invalid argument
+  FTP_STATUS_TRANSFER_ERROR,        // data transfer short or aborted, see bytes
+  FTP_STATUS_NO_MEMORY,             // no arena set, or arena too small, see setArena()
+  FTP_STATUS_TLS_DATA_REFUSED       // FTPS server refused the data connection (522 / 425), see require_ssl_reuse
+} FtpStatus;
+
+// Result of every call. code is the last FTP reply code (0 if none), bytes the data bytes sent or received
+// (number of entries for ContentList, file size for GetFileSize)
+typedef struct
+{
+  FtpStatus status;
+  uint16_t  code;
+  uint32_t  bytes;
+
+  bool ok() const
+  {
+    return (status == FTP_STATUS_OK);
+  }
+
+  explicit operator bool() const
+  {
+    return (status == FTP_STATUS_OK);
+  }
+} FtpResult;
+
+inline FtpResult FtpMakeResult(FtpStatus status, uint16_t code = 0, uint32_t bytes = 0)
+{
+  FtpResult res = { status, code, bytes };
+
+  return res;
+}
+
+/////////////////////////////////////////////
+
+typedef struct
+{
+  uint32_t  bytesRequested;     // bytes passed to WriteData() / Write()
+  uint32_t  bytesSent;          // bytes accepted by the client
+  uint32_t  shortWrites;        // write() accepted only part of the chunk
+  uint32_t  stalls;             // write() accepted nothing, had to back off
+} FTPTransferStats;
+
+/////////////////////////////////////////////
+
+// Per-phase caps, in ms. Each wait uses the smaller of its cap and what is left of the deadline
+typedef struct
+{
+  uint32_t  connect;      // TCP connect of control / data connection
+  uint32_t  reply;        // server reply, and first byte of a data transfer
+  uint32_t  dataIdle;     // silence between two data chunks
+  uint32_t  close;        // final reply after closing the data connection
+} FTPTimeouts;
+
+/////////////////////////////////////////////
+
+// Overall deadline, wraparound-safe as it only compares elapsed time
+class FTPDeadline
+{
+  public:
+
+    // budgetMs = 0 : no deadline
+    void start(uint32_t budgetMs)
+    {
+      _start  = millis();
+      _budget = budgetMs;
+    }
+
+    uint32_t remaining() const
+    {
+      if (_budget == 0)
+        return 0xFFFFFFFFUL;
+
+      uint32_t elapsed = millis() - _start;
+
+      return (elapsed >= _budget) ? 0 : _budget - elapsed;
+    }
+
+    bool expired() const
+    {
+      return (remaining() == 0);
+    }
+
+  private:
+
+    unsigned long _start  = 0;
+    uint32_t      _budget = 0;
+};
+
+/////////////////////////////////////////////
+
+// Server capabilities from the FEAT answer, see hasFeature()
+typedef enum : uint16_t
+{
+  FTP_FEATURE_MLSD          = 0x0001,
+  FTP_FEATURE_SIZE          = 0x0002,
+  FTP_FEATURE_MDTM          = 0x0004,
+  FTP_FEATURE_REST_STREAM   = 0x0008,
+  FTP_FEATURE_EPSV          = 0x0010,
+  FTP_FEATURE_UTF8          = 0x0020,
+  FTP_FEATURE_HASH          = 0x0040,
+  FTP_FEATURE_XCRC          = 0x0080,
+  FTP_FEATURE_MODE_Z        = 0x0100,
+  FTP_FEATURE_TVFS          = 0x0200
+} FtpFeature;
+
+/////////////////////////////////////////////
+
+// Called for each line of a directory listing. index starts at 0
+typedef void (*FTPLineCallback)(const char * line, uint16_t index, void * context);
+
+// Upload source, such as an SD file read. Fills buf with up to len bytes and returns how many, 0 at the end
+typedef uint16_t (*FTPDataProducer)(uint8_t * buf, uint16_t len, void * context);
 
 /////////////////////////////////////////////
 
@@ -105,7 +390,33 @@ class FTPClient_Generic
 {
   private:
   
-    void WriteClientBuffered(theFTPClient* cli, unsigned char * data, int dataLength);
+    size_t WriteClientBuffered(theFTPClient* cli, const unsigned char * data, size_t dataLength);
+    size_t WriteClientFully(theFTPClient* cli, const unsigned char * data, size_t dataLength);
+    bool   WaitForData(size_t received, size_t expected, unsigned long& lastRx);
+    size_t ParseTransferSize(const char * reply);
+    FtpResult StartDataTransfer(const __FlashStringHelper * command, const char * arg);
+    FtpResult CheckDataReply(FtpResult res);
+    FtpResult EndDataTransfer(FtpStatus status, uint32_t bytes);
+
+    bool          _finalReplyReceived = false;
+    uint16_t ReceiveLines(char * line, FTPLineCallback onLine, void * context, uint16_t maxLines);
+    FtpResult ReceiveListing(const __FlashStringHelper * command, const char * dir, FTPLineCallback onLine,
+                             void * context, uint16_t maxLines);
+
+#if FTP_CLIENT_USING_STRING
+    static void StoreLine(const char * line, uint16_t index, void * context);
+    static void StoreLineName(const char * line, uint16_t index, void * context);
+#endif
+
+    // Flat char buffer of maxLines * lineSize bytes, for the String-free listing
+    typedef struct
+    {
+      char *    buf;
+      uint16_t  lineSize;
+    } FTPLineBuffer;
+
+    static void StoreLineBuffer(const char * line, uint16_t index, void * context);
+    static void StoreLineBufferName(const char * line, uint16_t index, void * context);
     
     theFTPClient  client;
     theFTPClient  dclient;
@@ -118,44 +429,234 @@ class FTPClient_Generic
     char*         serverAdress;
     uint16_t      port;
     bool          _isConnected = false;
-    unsigned char clientBuf[BUFFER_SIZE];
     size_t        bufferSize = BUFFER_SIZE;
-    uint16_t      timeout = TIMEOUT_MS;
+
+#if FTP_CLIENT_USING_FTPS
+    size_t        _writeChunk = FTP_TLS_RECORD_SIZE;
+#else
+    size_t        _writeChunk = BUFFER_SIZE;
+#endif
+
+#if FTP_CLIENT_USING_ARENA
+    FTPArena *      _arena      = NULL;
+    size_t          _arenaMark  = 0;
+    unsigned char * clientBuf   = NULL;
+
+    bool          AcquireArena();
+    void          ReleaseArena();
+#else
+    unsigned char clientBuf[BUFFER_SIZE];
+#endif
+
+    FTPTimeouts   _timeouts = { TIMEOUT_MS, TIMEOUT_MS, FTP_DATA_IDLE_TIMEOUT_MS, TIMEOUT_MS };
+    FTPDeadline   _deadline;
+
+#if FTP_CLIENT_USING_FTPS
+    FtpResult     StartTLS();
+    FtpResult     ProtectDataChannel();
+
+  #if !FTP_FTPS_EXPLICIT
+    // Shared by the control and data connections, so each transfer is an abbreviated handshake
+    BearSSL::Session  _tlsSession;
+  #endif
+#endif
+
+#if FTP_CLIENT_USING_ACTIVE_MODE
+    theFTPServer* _dataServer = NULL;
+    IPAddress     _localIP;
+    uint16_t      _activePort = 0;
+    bool          _useEPRT    = false;
+
+    FtpResult     SendActivePort();
+    FtpResult     AcceptDataConnection(FtpResult res);
+#endif
+
+    uint32_t      Budget(uint32_t phaseMs);
+    void          SetConnectTimeout(theFTPClient& cli);
+    FtpResult     GetFTPAnswer (char* result, int offsetStart, uint32_t phaseMs);
     
     theFTPClient* GetDataClient();
 
+    FtpResult     EnterPassiveMode();
+    FtpResult     EnterExtendedPassiveMode();
+
+    // FEAT, read once per server after login
+    uint16_t      _features       = 0;
+    bool          _featuresKnown  = false;
+
+    FtpResult     ReadFeatures();
+    void          ParseFeature(const char * feature);
+
     // KH
     IPAddress     _dataAddress;
     uint16_t      _dataPort;
     
     bool          inASCIIMode = false;
+
+    // Keepalive, see tick()
+    uint32_t      _keepAliveInterval  = 0;
+    unsigned long _lastActivity       = 0;
+    unsigned long _noopSentAt         = 0;
+    bool          _noopPending        = false;
+
+    bool          ReadKeepAliveReply();
+    void          WaitKeepAliveReply();
+    void          ResetKeepAlive();
+
+    FTPTransferStats  _stats = { 0, 0, 0, 0 };
     //////
 
   public:
   
-    FTPClient_Generic(char* _serverAdress, uint16_t _port, char* _userName, char* _passWord, uint16_t _timeout = 10000);
-    FTPClient_Generic(char* _serverAdress, char* _userName, char* _passWord, uint16_t _timeout = 10000);
+    FTPClient_Generic(char* _serverAdress, uint16_t _port, char* _userName, char* _passWord,
+                      uint32_t _timeout = TIMEOUT_MS);
+    FTPClient_Generic(char* _serverAdress, char* _userName, char* _passWord, uint32_t _timeout = TIMEOUT_MS);
+    FTPClient_Generic();
+
+    void SetServer(char* _serverAdress, uint16_t _port, char* _userName, char* _passWord);
+    bool IsSameServer(const char* _serverAdress, uint16_t _port, const char* _userName);
     
-    void OpenConnection();
-    void CloseConnection();
+    FtpResult OpenConnection();
+    FtpResult CloseConnection();
     bool isConnected();
-    void NewFile (const char* fileName);
-    void AppendFile(const char* fileName);
-    void WriteData (unsigned char * data, int dataLength);
-    void CloseFile ();
-    void GetFTPAnswer (char* result = NULL, int offsetStart = 0);
-    void GetLastModifiedTime(const char* fileName, char* result);
-    void RenameFile(const char* from, const char* to);
-    void Write(const char * str);
-    void InitFile(const char* type);
-    void ChangeWorkDir(const char * dir);
-    void DeleteFile(const char * file);
-    void MakeDir(const char * dir);
-    void RemoveDir(const char * dir);
-    void ContentList(const char * dir, String * list);
-    void ContentListWithListCommand(const char * dir, String * list);
-    void DownloadString(const char * filename, String &str);
-    void DownloadFile(const char * filename, unsigned char * buf, size_t length, bool printUART = false);
+    FtpResult Noop();
+    bool tick();
+
+    // Send NOOP when the control connection has been idle for intervalMs. Set it below the server's
+    // idle timeout (vsftpd `idle_session_timeout`, 300s by default). 0 to disable
+    void setKeepAlive(uint32_t intervalMs)
+    {
+      _keepAliveInterval = intervalMs;
+    }
+
+    // millis() of the last reply on the control connection, including tick() NOOP replies
+    unsigned long LastReplyTime()
+    {
+      return _lastActivity;
+    }
+
+    FtpResult NewFile (const char* fileName);
+    FtpResult AppendFile(const char* fileName);
+    FtpResult WriteData (const unsigned char * data, int dataLength);
+    // data in PROGMEM, such as `const unsigned char image[] PROGMEM`
+    FtpResult WriteData_P(const unsigned char * data, size_t dataLength);
+    // dataLength bytes pulled from producer
+    FtpResult WriteData(FTPDataProducer producer, void * context, size_t dataLength);
+    FtpResult CloseFile ();
+    FtpResult GetFTPAnswer (char* result = NULL, int offsetStart = 0);
+    FtpResult GetLastModifiedTime(const char* fileName, char* result);
+    FtpResult GetFileSize(const char* fileName);
+    FtpResult RenameFile(const char* from, const char* to);
+    FtpResult Write(const char * str);
+    FtpResult InitFile(const char* type);
+    FtpResult ChangeWorkDir(const char * dir);
+    FtpResult DeleteFile(const char * file);
+    FtpResult MakeDir(const char * dir);
+    FtpResult RemoveDir(const char * dir);
+#if FTP_CLIENT_USING_STRING
+    FtpResult ContentList(const char * dir, String * list);
+    FtpResult ContentListWithListCommand(const char * dir, String * list);
+    FtpResult DownloadString(const char * filename, String &str);
+#endif
+
+    // No heap use. The callback gets the raw MLSD / LIST line
+    FtpResult ContentList(const char * dir, FTPLineCallback onLine, void * context = NULL, uint16_t maxLines = 0xFFFF);
+    FtpResult ContentListWithListCommand(const char * dir, FTPLineCallback onLine, void * context = NULL,
+                                         uint16_t maxLines = 0xFFFF);
+
+    // list is a char[maxLines][lineSize] buffer. Lines are NUL-terminated and truncated to lineSize - 1
+    FtpResult ContentList(const char * dir, char * list, uint16_t lineSize, uint16_t maxLines);
+    FtpResult ContentListWithListCommand(const char * dir, char * list, uint16_t lineSize, uint16_t maxLines);
+
+    // Downloads at most bufSize - 1 bytes and NUL-terminates buf
+    FtpResult DownloadString(const char * filename, char * buf, size_t bufSize);
+    FtpResult DownloadFile(const char * filename, unsigned char * buf, size_t length, bool printUART = false);
+    FtpResult DownloadFile(const char * filename, FTPDownloadSink& sink, size_t fileSize = 0);
+
+    void setTimeouts(uint32_t connectMs, uint32_t replyMs, uint32_t dataIdleMs, uint32_t closeMs)
+    {
+      _timeouts.connect   = connectMs;
+      _timeouts.reply     = replyMs;
+      _timeouts.dataIdle  = dataIdleMs;
+      _timeouts.close     = closeMs;
+    }
+
+    void setDataIdleTimeout(uint32_t _timeout)
+    {
+      _timeouts.dataIdle = _timeout;
+    }
+
+    // Every wait from now on ends within budgetMs in total, such as below the watchdog period.
+    // Covers a whole sequence (InitFile, NewFile, WriteData, CloseFile). 0 to clear
+    void setDeadline(uint32_t budgetMs)
+    {
+      _deadline.start(budgetMs);
+    }
+
+    bool deadlineExpired()
+    {
+      return _deadline.expired();
+    }
+
+    const FTPTransferStats& GetTransferStats()
+    {
+      return _stats;
+    }
+
+    // false if not supported, or if the server didn't answer FEAT. ContentList() and InitFile() use it
+    // to pick MLSD / EPSV without a trial-and-error round trip
+    bool hasFeature(FtpFeature feature)
+    {
+      return _featuresKnown && (_features & feature);
+    }
+
+    uint16_t GetFeatures()
+    {
+      return _featuresKnown ? _features : 0;
+    }
+
+    // Max bytes per client write() of WriteData() / Write(). Defaults to FTP_TLS_RECORD_SIZE with FTPS,
+    // BUFFER_SIZE otherwise
+    void setWriteChunkSize(size_t chunkSize)
+    {
+#if FTP_CLIENT_USING_FTPS
+      _writeChunk = (chunkSize > 0) ? chunkSize : FTP_TLS_RECORD_SIZE;
+#else
+      _writeChunk = (chunkSize > 0) ? chunkSize : BUFFER_SIZE;
+#endif
+    }
+
+#if FTP_CLIENT_USING_FTPS
+  #if FTP_FTPS_EXPLICIT
+    // Root CA of the FTP server, for the control and data connections. NULL to skip the check (test only)
+    void setCACert(const char * rootCA);
+  #else
+    // Trust anchors of the FTP server, for the control and data connections. NULL to skip the check (test only)
+    void setTrustAnchors(const BearSSL::X509List * ta);
+  #endif
+#endif
+
+#if FTP_CLIENT_USING_ACTIVE_MODE
+    // Active mode : the FTP server connects back to localIP:dataPort, where dataServer listens. dataServer
+    // must have been created with dataPort, such as `EthernetServer dataServer(dataPort)`.
+    // useEPRT to send `EPRT |1|ip|port|` instead of `PORT h1,h2,h3,h4,p1,p2`
+    void setActiveMode(theFTPServer& dataServer, IPAddress localIP, uint16_t dataPort, bool useEPRT = false);
+
+    // Back to PASV, the default
+    void setPassiveMode()
+    {
+      _dataServer = NULL;
+    }
+#endif
+
+#if FTP_CLIENT_USING_ARENA
+    // Arena for the transfer buffers. Must outlive the transfers, and not be used by another
+    // session during a transfer
+    void setArena(FTPArena& arena)
+    {
+      _arena = &arena;
+    }
+#endif
 };
 
 #endif  // FTPCLIENT_GENERIC_HPP
@@ -0,0 +1,116 @@
+/****************************************************************************************************************************
+  FTPClient_Generic_Arena.h
+
+  FTP Client for Generic boards using SD, FS, etc.
+
+  Based on and modified from
+
+  1) esp32_ftpclient Library         https://github.com/ldab/ESP32_FTPClient
+
+  Built by Khoi Hoang https://github.com/khoih-prog/FTPClient_Generic
+
+  Version: 1.6.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0   K Hoang      11/05/2022 Initial porting and coding to support many more boards, using WiFi or Ethernet
+  1.1.0   K Hoang      13/05/2022 Add support to Teensy 4.1 using QNEthernet or NativeEthernet
+  1.2.0   K Hoang      14/05/2022 Add support to other FTP Servers. Fix bug
+  1.2.1   K Hoang      14/05/2022 Auto detect server response type in PASV mode
+  1.3.0   K Hoang      16/05/2022 Fix uploading issue of large files for WiFi, QNEthernet
+  1.4.0   K Hoang      05/11/2022 Add support to ESP32/ESP8266 using Ethernet W5x00 or ENC28J60
+  1.5.0   K Hoang      20/01/2023 Add support to RP2040W using `arduino-pico` core
+  1.5.0   K Hoang      20/01/2023 Add support to Ethernet W6100 using Ethernet_Generic library
+ *****************************************************************************************************************************/
+
+
+#pragma once
+
+#ifndef FTPCLIENT_GENERIC_ARENA_H
+#define FTPCLIENT_GENERIC_ARENA_H
+
+/////////////////////////////////////////////
+
+// Every block handed out by FTPArena is aligned to this
+#ifndef FTP_ARENA_ALIGN
+  #define FTP_ARENA_ALIGN             4
+#endif
+
+/////////////////////////////////////////////
+
+// Bump allocator over a caller-provided buffer, such as `static uint8_t arena[FTP_ARENA_SIZE]`.
+// Blocks are freed all at once by going back to a mark(). Nothing comes from malloc
+class FTPArena
+{
+  public:
+
+    FTPArena(uint8_t * mem, size_t size) : _mem(mem), _size(size)
+    {
+    }
+
+    // Returns NULL if the arena is full
+    void * alloc(size_t len)
+    {
+      // Align the address, not the offset, as mem may not be aligned
+      uintptr_t addr  = (uintptr_t) &_mem[_used];
+      size_t    start = _used + ( ( FTP_ARENA_ALIGN - (addr % FTP_ARENA_ALIGN) ) % FTP_ARENA_ALIGN );
+
+      if ( (start > _size) || (len > _size - start) )
+      {
+        FTP_LOGERROR3(F("FTPArena: out of memory, requested ="), len, F(", free ="), _size - _used);
+
+        return NULL;
+      }
+
+      _used = start + len;
+
+      if (_used > _peak)
+        _peak = _used;
+
+      return &_mem[start];
+    }
+
+    size_t mark()
+    {
+      return _used;
+    }
+
+    // Frees every block allocated since mark was taken
+    void release(size_t mark)
+    {
+      if (mark < _used)
+        _used = mark;
+    }
+
+    void reset()
+    {
+      _used = 0;
+    }
+
+    size_t used()
+    {
+      return _used;
+    }
+
+    // High-water mark, to size the arena
+    size_t peak()
+    {
+      return _peak;
+    }
+
+    size_t size()
+    {
+      return _size;
+    }
+
+  private:
+
+    uint8_t * _mem;
+    size_t    _size;
+    size_t    _used   = 0;
+    size_t    _peak   = 0;
+};
+
+/////////////////////////////////////////////
+
+#endif    // FTPCLIENT_GENERIC_ARENA_H
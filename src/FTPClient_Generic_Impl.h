@@ -30,6 +30,11 @@
 
 #include "FTPClient_Generic.hpp"
 
+#if !FTP_CLIENT_USING_STRING
+  // Any `String` left in the library code below fails to compile in String-free mode
+  #define String      FTP_CLIENT_USING_STRING_is_false_String_not_allowed
+#endif
+
 #if !defined(USING_NEW_PASSIVE_MODE_ANSWER_TYPE)
   #define USING_NEW_PASSIVE_MODE_ANSWER_TYPE    true
 #endif
@@ -37,24 +42,89 @@
 /////////////////////////////////////////////
 
 FTPClient_Generic::FTPClient_Generic(char* _serverAdress, uint16_t _port, char* _userName, char* _passWord,
-                                     uint16_t _timeout)
+                                     uint32_t _timeout)
 {
   userName      = _userName;
   passWord      = _passWord;
   serverAdress  = _serverAdress;
   port          = _port;
-  timeout       = _timeout;
+
+  _timeouts.connect = _timeout;
+  _timeouts.reply   = _timeout;
+  _timeouts.close   = _timeout;
 }
 
 /////////////////////////////////////////////
 
-FTPClient_Generic::FTPClient_Generic(char* _serverAdress, char* _userName, char* _passWord, uint16_t _timeout)
+FTPClient_Generic::FTPClient_Generic(char* _serverAdress, char* _userName, char* _passWord, uint32_t _timeout)
 {
   userName      = _userName;
   passWord      = _passWord;
   serverAdress  = _serverAdress;
   port          = FTP_PORT;
-  timeout       = _timeout;
+
+  _timeouts.connect = _timeout;
+  _timeouts.reply   = _timeout;
+  _timeouts.close   = _timeout;
+}
+
+/////////////////////////////////////////////
+
+// Server to be set later with SetServer(), such as by FTPClient_Generic_Pool
+FTPClient_Generic::FTPClient_Generic()
+{
+  userName      = NULL;
+  passWord      = NULL;
+  serverAdress  = NULL;
+  port          = FTP_PORT;
+}
+
+/////////////////////////////////////////////
+
+void FTPClient_Generic::SetServer(char* _serverAdress, uint16_t _port, char* _userName, char* _passWord)
+{
+  // Capabilities cached by OpenConnection() belong to the previous server
+  if (!IsSameServer(_serverAdress, _port, _userName))
+    _featuresKnown = false;
+
+  userName      = _userName;
+  passWord      = _passWord;
+  serverAdress  = _serverAdress;
+  port          = _port;
+}
+
+/////////////////////////////////////////////
+
+bool FTPClient_Generic::IsSameServer(const char* _serverAdress, uint16_t _port, const char* _userName)
+{
+  if ( (serverAdress == NULL) || (userName == NULL) )
+    return false;
+
+  return ( (port == _port) && (strcmp(serverAdress, _serverAdress) == 0) && (strcmp(userName, _userName) == 0) );
+}
+
+/////////////////////////////////////////////
+
+// Time allowed for the next wait : phase cap, shortened to what is left of the deadline
+uint32_t FTPClient_Generic::Budget(uint32_t phaseMs)
+{
+  uint32_t remaining = _deadline.remaining();
+
+  return (remaining < phaseMs) ? remaining : phaseMs;
+}
+
+/////////////////////////////////////////////
+
+// For libraries whose connect() has no timeout parameter
+void FTPClient_Generic::SetConnectTimeout(theFTPClient& cli)
+{
+#if (FTP_CLIENT_USING_ETHERNET && USE_ETHERNET_GENERIC)
+  uint32_t budget = Budget(_timeouts.connect);
+
+  cli.setConnectionTimeout( (budget > 0xFFFF) ? 0xFFFF : budget );
+#else
+  (void) cli;
+#endif
 }
 
 /////////////////////////////////////////////
@@ -68,6 +138,10 @@ theFTPClient* FTPClient_Generic::GetDataClient()
 
 bool FTPClient_Generic::isConnected()
 {
+  // A keepalive NOOP is in flight. Its reply must be consumed before the next command is sent
+  if (_noopPending)
+    WaitKeepAliveReply();
+
   if (!_isConnected)
   {
     FTP_LOGWARN1("FTP error: ", outBuf);
@@ -78,266 +152,1204 @@ bool FTPClient_Generic::isConnected()
 
 /////////////////////////////////////////////
 
-void FTPClient_Generic::GetLastModifiedTime(const char  * fileName, char* result)
+// Keepalive / liveness check of the control connection
+FtpResult FTPClient_Generic::Noop()
 {
-  FTP_LOGINFO("Send MDTM");
+  FTP_LOGINFO("Send NOOP");
 
   if (!isConnected())
   {
-    FTP_LOGERROR("GetLastModifiedTime: Not connected error");
-    return;
+    FTP_LOGERROR("Noop: Not connected error");
+    return FtpMakeResult(FTP_STATUS_NOT_CONNECTED);
   }
 
-  client.print(COMMAND_FILE_LAST_MOD_TIME);
-  client.println(fileName);
-  GetFTPAnswer (result, 4);
+  client.println(COMMAND_NOOP);
+
+  return GetFTPAnswer();
 }
 
 /////////////////////////////////////////////
 
-void FTPClient_Generic::WriteClientBuffered(theFTPClient* cli, unsigned char * data, int dataLength)
+// Non-blocking keepalive, to be called often from loop(). Returns false if the session is gone or stale
+bool FTPClient_Generic::tick()
 {
-  if (!isConnected())
-    return;
+  if (!_isConnected)
+    return false;
 
-  size_t clientCount = 0;
+  if (_noopPending)
+  {
+    if (ReadKeepAliveReply())
+      return _isConnected;
+
+    if (millis() - _noopSentAt > _timeouts.reply)
+    {
+      FTP_LOGERROR("tick: no NOOP reply, session stale");
+
+      strcpy(outBuf, "Stale");
+      _noopPending  = false;
+      _isConnected  = false;
+      client.stop();
+    }
+
+    return _isConnected;
+  }
+
+  // Not while a transfer is running, the reply would only come after the transfer
+  if ( (_keepAliveInterval == 0) || dclient.connected() || (millis() - _lastActivity < _keepAliveInterval) )
+    return true;
 
-  for (int i = 0; i < dataLength; i++)
+  FTP_LOGDEBUG("tick: Send NOOP");
+
+  client.println(COMMAND_NOOP);
+
+  outCount      = 0;
+  outBuf[0]     = 0;
+  _noopPending  = true;
+  _noopSentAt   = millis();
+
+  return true;
+}
+
+/////////////////////////////////////////////
+
+// Read whatever part of the NOOP reply has arrived, without waiting. Returns true once the reply is complete
+bool FTPClient_Generic::ReadKeepAliveReply()
+{
+  while (client.available())
   {
-    clientBuf[clientCount] = data[i];
-    clientCount++;
+    char thisByte = client.read();
 
-    if (clientCount > bufferSize - 1)
+    if (outCount < sizeof(outBuf) - 1)
     {
-#if FTP_CLIENT_USING_QNETHERNET
-      cli->writeFully(clientBuf, bufferSize);
-#else
-      cli->write(clientBuf, bufferSize);
-#endif
+      outBuf[outCount++] = thisByte;
+      outBuf[outCount]   = 0;
+    }
+
+    if (thisByte == '\n')
+    {
+      _noopPending  = false;
+      _lastActivity = millis();
+
+      if ( (strtoul(outBuf, NULL, 10) == SERVICE_NOT_AVAILABLE) || !client.connected() )
+        _isConnected = false;
 
-      FTP_LOGDEBUG3("Written: num bytes = ", bufferSize, ", index = ", i);
-      FTP_LOGDEBUG3("Written: clientBuf = ", (uint32_t) clientBuf, ", clientCount = ", clientCount);
+      FTP_LOGDEBUG1("tick: NOOP reply =", outBuf);
 
-      clientCount = 0;
+      return true;
     }
   }
 
-  if (clientCount > 0)
-  {
-    cli->write(clientBuf, clientCount);
+  return false;
+}
+
+/////////////////////////////////////////////
+
+void FTPClient_Generic::WaitKeepAliveReply()
+{
+  uint32_t budget = Budget(_timeouts.reply);
+
+  while ( !ReadKeepAliveReply() && (millis() - _noopSentAt <= budget) )
+    delay(1);
 
-    FTP_LOGDEBUG1("Last Written: num bytes = ", clientCount);
+  if (_noopPending)
+  {
+    strcpy(outBuf, "Stale");
+    _noopPending  = false;
+    _isConnected  = false;
+    client.stop();
   }
 }
 
 /////////////////////////////////////////////
 
-void FTPClient_Generic::GetFTPAnswer (char* result, int offsetStart)
+void FTPClient_Generic::ResetKeepAlive()
 {
-  char thisByte;
-  outCount = 0;
+  _noopPending  = false;
+  _noopSentAt   = 0;
+  _lastActivity = millis();
+}
 
-  unsigned long _m = millis();
+/////////////////////////////////////////////
 
-  while (!client.available() && millis() < _m + timeout)
-    delay(100);
+FtpResult FTPClient_Generic::GetLastModifiedTime(const char  * fileName, char* result)
+{
+  FTP_LOGINFO("Send MDTM");
 
-  if ( !client.available())
+  if (!isConnected())
   {
-    memset( outBuf, 0, sizeof(outBuf) );
-    strcpy( outBuf, "Offline");
+    FTP_LOGERROR("GetLastModifiedTime: Not connected error");
+    return FtpMakeResult(FTP_STATUS_NOT_CONNECTED);
+  }
 
-    _isConnected = false;
-    isConnected();
+  client.print(COMMAND_FILE_LAST_MOD_TIME);
+  client.println(fileName);
+  return GetFTPAnswer (result, 4);
+}
+
+/////////////////////////////////////////////
+
+// Returns 0 if the server doesn't support SIZE or the file doesn't exist
+FtpResult FTPClient_Generic::GetFileSize(const char * fileName)
+{
+  FTP_LOGINFO("Send SIZE");
 
-    return;
+  if (!isConnected())
+  {
+    FTP_LOGERROR("GetFileSize: Not connected error");
+    return FtpMakeResult(FTP_STATUS_NOT_CONNECTED);
   }
 
-  while (client.available())
+  if ( _featuresKnown && !hasFeature(FTP_FEATURE_SIZE) )
   {
-    thisByte = client.read();
+    FTP_LOGWARN("GetFileSize: SIZE not supported by server");
+    return FtpMakeResult(FTP_STATUS_SERVER_ERROR, COMMAND_NOT_IMPLEMENTED);
+  }
+
+  client.print(COMMAND_FILE_SIZE);
+  client.println(fileName);
+
+  FtpResult res = GetFTPAnswer();
+
+  if (res.code != FILE_STATUS)
+    return res;
+
+  // 213 <size>
+  res.bytes = strtoul(&outBuf[4], NULL, 10);
+
+  return res;
+}
+
+/////////////////////////////////////////////
+
+// Extract the size from a `150 Opening BINARY mode data connection for file (1234 bytes)` reply.
+// Returns 0 if the server doesn't report it
+size_t FTPClient_Generic::ParseTransferSize(const char * reply)
+{
+  char *tmpPtr;
+
+  if (strtol(reply, &tmpPtr, 10) != FILE_STATUS_OK)
+    return 0;
+
+  const char * sizePtr = strrchr(reply, '(');
+
+  if (sizePtr == NULL)
+    return 0;
+
+  size_t size = strtoul(sizePtr + 1, &tmpPtr, 10);
+
+  return (strncmp(tmpPtr, " bytes", 6) == 0) ? size : 0;
+}
+
+/////////////////////////////////////////////
 
-    if (outCount < sizeof(outBuf))
+// Returns true when there is data to read on the data connection, false when the transfer is over :
+// expected byte count reached, data connection closed by server (EOF), or no data for too long.
+// The first byte may take up to the reply timeout, then the data-idle timeout applies between chunks
+bool FTPClient_Generic::WaitForData(size_t received, size_t expected, unsigned long& lastRx)
+{
+  if ( (expected > 0) && (received >= expected) )
+    return false;
+
+  unsigned long idleLimit = (received == 0) ? _timeouts.reply : _timeouts.dataIdle;
+
+  while (!dclient.available())
+  {
+    if (!dclient.connected())
     {
-      outBuf[outCount] = thisByte;
-      outCount++;
-      outBuf[outCount] = 0;
+      // Closed, but the stack may still hold the last segment
+      return (dclient.available() > 0);
     }
-  }
 
-  if (outBuf[0] == '4' || outBuf[0] == '5' )
-  {
-    _isConnected = false;
-    isConnected();
+    if ( (millis() - lastRx > idleLimit) || _deadline.expired() )
+    {
+      FTP_LOGERROR3("WaitForData: data timeout, received =", received, ", expected =", expected);
+      return false;
+    }
 
-    return;
+    delay(1);
   }
-  else
+
+  lastRx = millis();
+
+  return true;
+}
+
+/////////////////////////////////////////////
+
+// Close the data connection of a download / listing and read the final `226` reply, unless it already came
+// together with the `150` one (small files). Returns status of the data transfer, or of the final reply
+FtpResult FTPClient_Generic::EndDataTransfer(FtpStatus status, uint32_t bytes)
+{
+  dclient.stop();
+
+#if FTP_CLIENT_USING_ARENA
+  ReleaseArena();
+#endif
+
+  FtpResult res = FtpMakeResult(status, 0, bytes);
+
+  if (_finalReplyReceived)
+    return res;
+
+  FtpResult closeRes = GetFTPAnswer(NULL, 0, _timeouts.close);
+
+  if ( (status == FTP_STATUS_OK) && !closeRes )
+    res.status = closeRes.status;
+
+  res.code = closeRes.code;
+
+  return res;
+}
+
+/////////////////////////////////////////////
+
+// Send a command opening a data transfer (RETR, LIST, MLSD) and check its preliminary reply
+FtpResult FTPClient_Generic::StartDataTransfer(const __FlashStringHelper * command, const char * arg)
+{
+#if FTP_CLIENT_USING_ARENA
+
+  if (!AcquireArena())
   {
-    _isConnected = true;
+    dclient.stop();
+
+    return FtpMakeResult(FTP_STATUS_NO_MEMORY);
   }
 
-  if (result != NULL)
+#endif
+
+  client.print(command);
+  client.println(arg);
+
+  char _resp[ sizeof(outBuf) ];
+  FtpResult res = CheckDataReply(GetFTPAnswer(_resp));
+
+#if FTP_CLIENT_USING_ACTIVE_MODE
+  res = AcceptDataConnection(res);
+#endif
+
+  // `150 Opening ...\r\n226 Transfer complete` in one read
+  const char * nextLine = strchr(outBuf, '\n');
+
+  _finalReplyReceived = ( (nextLine != NULL) && (nextLine[1] == '2') );
+
+  if (!res)
   {
-    // Deprecated
-    for (uint32_t i = offsetStart; i < sizeof(outBuf); i++)
-    {
-      result[i] = outBuf[i - offsetStart];
-    }
+    dclient.stop();
 
-    FTP_LOGDEBUG1("Result: ", outBuf);
+#if FTP_CLIENT_USING_ARENA
+    ReleaseArena();
+#endif
   }
+
+  return res;
 }
 
 /////////////////////////////////////////////
 
-void FTPClient_Generic::WriteData (unsigned char * data, int dataLength)
+// Reply to STOR / APPE / RETR / LIST / MLSD. With FTPS, 522 / 425 mean the server refused the TLS
+// data connection. The ESP32 client can't resume the control connection TLS session on the data
+// connection, and servers requiring it (vsftpd `require_ssl_reuse=YES`, the default) refuse every transfer
+FtpResult FTPClient_Generic::CheckDataReply(FtpResult res)
 {
-  FTP_LOGDEBUG(F("Writing"));
+#if FTP_CLIENT_USING_FTPS
 
-  if (!isConnected())
+  if ( (res.code == DATA_TLS_REFUSED) || (res.code == DATA_CONNECTION_FAILED) )
   {
-    FTP_LOGERROR("WriteData: Not connected error");
-    return;
+    FTP_LOGERROR1(F("Data TLS connection refused, session reuse required ? :"), outBuf);
+    dclient.stop();
+
+    return FtpMakeResult(FTP_STATUS_TLS_DATA_REFUSED, res.code);
   }
 
-  FTP_LOGDEBUG1("WriteData: datalen = ", dataLength);
+#endif
 
-  WriteClientBuffered(&dclient, &data[0], dataLength);
+  return res;
 }
 
 /////////////////////////////////////////////
 
-void FTPClient_Generic::CloseFile ()
-{
-  FTP_LOGDEBUG(F("Close File"));
-  dclient.stop();
+#if FTP_CLIENT_USING_ARENA
 
-  if (!isConnected())
+// Take the data buffer of a transfer from the arena. Everything allocated until ReleaseArena(), such as
+// the listing line buffer, is given back at once
+bool FTPClient_Generic::AcquireArena()
+{
+  if (_arena == NULL)
   {
-    FTP_LOGERROR("CloseFile: Not connected error");
-    return;
+    FTP_LOGERROR(F("AcquireArena: no arena, call setArena()"));
+
+    return false;
   }
 
-  GetFTPAnswer();
+  _arenaMark  = _arena->mark();
+  clientBuf   = (unsigned char *) _arena->alloc(bufferSize);
+
+  return (clientBuf != NULL);
 }
 
 /////////////////////////////////////////////
 
-void FTPClient_Generic::Write(const char * str)
+void FTPClient_Generic::ReleaseArena()
 {
-  FTP_LOGDEBUG(F("Write File"));
+  if ( (_arena != NULL) && (clientBuf != NULL) )
+  {
+    _arena->release(_arenaMark);
+    clientBuf = NULL;
+  }
+}
 
-  if (!isConnected())
+/////////////////////////////////////////////
+
+#endif    // FTP_CLIENT_USING_ARENA
+
+// Split the data connection stream into lines of up to FTP_LINE_BUFFER_SIZE in line, reading it in bufferSize
+// chunks. The `\n` separator is dropped, as with readStringUntil('\n')
+uint16_t FTPClient_Generic::ReceiveLines(char * line, FTPLineCallback onLine, void * context, uint16_t maxLines)
+{
+  size_t    lineLen   = 0;
+  size_t    received  = 0;
+  uint16_t  lines     = 0;
+
+  unsigned long _m = millis();
+
+  while ( (lines < maxLines) && WaitForData(received, 0, _m) )
   {
-    FTP_LOGERROR("Write: Not connected error");
-    return;
+    size_t toRead = dclient.available();
+
+    if (toRead > bufferSize)
+      toRead = bufferSize;
+
+    int len = dclient.read(clientBuf, toRead);
+
+    if (len <= 0)
+      continue;
+
+    received += len;
+
+    for (int i = 0; (i < len) && (lines < maxLines); i++)
+    {
+      if (clientBuf[i] == '\n')
+      {
+        line[lineLen] = 0;
+        onLine(line, lines++, context);
+        lineLen = 0;
+      }
+      else if (lineLen < FTP_LINE_BUFFER_SIZE - 1)
+      {
+        line[lineLen++] = clientBuf[i];
+      }
+    }
   }
 
-  GetDataClient()->print(str);
+  // Last line without trailing `\n`
+  if ( (lineLen > 0) && (lines < maxLines) )
+  {
+    line[lineLen] = 0;
+    onLine(line, lines++, context);
+  }
+
+  return lines;
 }
 
 /////////////////////////////////////////////
 
-void FTPClient_Generic::CloseConnection()
+#if FTP_CLIENT_USING_STRING
+
+void FTPClient_Generic::StoreLine(const char * line, uint16_t index, void * context)
 {
-  client.println(COMMAND_QUIT);
-  client.stop();
-  FTP_LOGINFO(F("Connection closed"));
+  ((String *) context)[index] = line;
 }
 
 /////////////////////////////////////////////
 
-void FTPClient_Generic::OpenConnection()
+// LIST answer, keep only the file name (last field)
+void FTPClient_Generic::StoreLineName(const char * line, uint16_t index, void * context)
 {
-  FTP_LOGINFO1(F("Connecting to: "), serverAdress);
+  const char * name = strrchr(line, ' ');
 
-#if ( (ESP32) && !FTP_CLIENT_USING_ETHERNET )
+  ((String *) context)[index] = (name == NULL) ? line : name + 1;
+}
 
-  if ( client.connect(serverAdress, port, timeout) )
-#else
-  if ( client.connect(serverAdress, port) )
-#endif
-  {
-    FTP_LOGINFO(F("Command connected"));
-  }
+/////////////////////////////////////////////
+
+#endif    // FTP_CLIENT_USING_STRING
+
+void FTPClient_Generic::StoreLineBuffer(const char * line, uint16_t index, void * context)
+{
+  FTPLineBuffer * lb = (FTPLineBuffer *) context;
+  char *          dst = &lb->buf[(size_t) index * lb->lineSize];
+
+  strncpy(dst, line, lb->lineSize - 1);
+  dst[lb->lineSize - 1] = 0;
+}
+
+/////////////////////////////////////////////
 
-  GetFTPAnswer();
+// LIST answer, keep only the file name (last field)
+void FTPClient_Generic::StoreLineBufferName(const char * line, uint16_t index, void * context)
+{
+  const char * name = strrchr(line, ' ');
+
+  StoreLineBuffer( (name == NULL) ? line : name + 1, index, context);
+}
+
+/////////////////////////////////////////////
 
-  FTP_LOGINFO1("Send USER = ", userName);
+// Write the whole chunk, handling partial writes when the TX buffer is full (W5x00, ENC28J60, WiFiNINA).
+// Returns the number of bytes actually accepted by the client
+size_t FTPClient_Generic::WriteClientFully(theFTPClient* cli, const unsigned char * data, size_t dataLength)
+{
+  size_t  sent    = 0;
+  uint8_t retries = 0;
 
-  client.print(COMMAND_USER);
-  client.println(userName);
+  while (sent < dataLength)
+  {
+#if FTP_CLIENT_USING_QNETHERNET
+    size_t written = cli->writeFully(&data[sent], dataLength - sent);
+#else
+    size_t written = cli->write(&data[sent], dataLength - sent);
+#endif
+
+    if (written > 0)
+    {
+      if (written < dataLength - sent)
+        _stats.shortWrites++;
+
+      sent    += written;
+      retries = 0;
+
+      continue;
+    }
+
+    // Nothing accepted. Back off to let the stack drain its TX buffer
+    _stats.stalls++;
+
+    if ( !cli->connected() || (++retries > FTP_WRITE_MAX_RETRIES) || _deadline.expired() )
+    {
+      FTP_LOGERROR3("WriteClientFully: write stalled, sent =", sent, ", requested =", dataLength);
+      break;
+    }
+
+    delay(FTP_WRITE_RETRY_DELAY_MS * retries);
+  }
+
+  _stats.bytesSent += sent;
+
+  return sent;
+}
+
+/////////////////////////////////////////////
+
+size_t FTPClient_Generic::WriteClientBuffered(theFTPClient* cli, const unsigned char * data, size_t dataLength)
+{
+  if (!isConnected())
+    return 0;
+
+  size_t written = 0;
+
+  _stats.bytesRequested += dataLength;
+
+  while (written < dataLength)
+  {
+    size_t chunk = dataLength - written;
+
+    if (chunk > _writeChunk)
+      chunk = _writeChunk;
+
+    size_t sent = WriteClientFully(cli, &data[written], chunk);
+
+    written += sent;
+
+    FTP_LOGDEBUG3("Written: num bytes = ", sent, ", total = ", written);
+
+    if (sent < chunk)
+    {
+      FTP_LOGERROR3("WriteClientBuffered: short write, sent =", written, ", requested =", dataLength);
+      break;
+    }
+  }
+
+  return written;
+}
+
+/////////////////////////////////////////////
+
+FtpResult FTPClient_Generic::GetFTPAnswer (char* result, int offsetStart)
+{
+  return GetFTPAnswer(result, offsetStart, _timeouts.reply);
+}
+
+/////////////////////////////////////////////
+
+FtpResult FTPClient_Generic::GetFTPAnswer (char* result, int offsetStart, uint32_t phaseMs)
+{
+  char thisByte;
+  outCount = 0;
+
+  unsigned long _m      = millis();
+  uint32_t      budget  = Budget(phaseMs);
+
+  // Elapsed-time compare, safe across millis() wraparound
+  while (!client.available() && (millis() - _m < budget))
+    delay(1);
+
+  if ( !client.available())
+  {
+    memset( outBuf, 0, sizeof(outBuf) );
+    strcpy( outBuf, "Offline");
+
+    _isConnected = false;
+    isConnected();
+
+    return FtpMakeResult(_deadline.expired() ? FTP_STATUS_DEADLINE : FTP_STATUS_TIMEOUT);
+  }
+
+  while (client.available())
+  {
+    thisByte = client.read();
+
+    if (outCount < sizeof(outBuf) - 1)
+    {
+      outBuf[outCount] = thisByte;
+      outCount++;
+      outBuf[outCount] = 0;
+    }
+  }
+
+  _lastActivity = millis();
+
+  uint16_t code = strtoul(outBuf, NULL, 10);
+
+  if (outBuf[0] == '4' || outBuf[0] == '5' )
+  {
+    // Only a 421 or a closed socket ends the session. After any other error, such as 550, it stays usable
+    if ( (code == SERVICE_NOT_AVAILABLE) || !client.connected() )
+    {
+      _isConnected = false;
+      isConnected();
+    }
+
+    return FtpMakeResult(FTP_STATUS_SERVER_ERROR, code);
+  }
+  else
+  {
+    _isConnected = true;
+  }
+
+  if (result != NULL)
+  {
+    // Deprecated
+    for (uint32_t i = offsetStart; i < sizeof(outBuf); i++)
+    {
+      result[i] = outBuf[i - offsetStart];
+    }
+
+    FTP_LOGDEBUG1("Result: ", outBuf);
+  }
+
+  return FtpMakeResult(FTP_STATUS_OK, code);
+}
+
+/////////////////////////////////////////////
+
+FtpResult FTPClient_Generic::WriteData (const unsigned char * data, int dataLength)
+{
+  FTP_LOGDEBUG(F("Writing"));
+
+  if (!isConnected())
+  {
+    FTP_LOGERROR("WriteData: Not connected error");
+    return FtpMakeResult(FTP_STATUS_NOT_CONNECTED);
+  }
+
+  FTP_LOGDEBUG1("WriteData: datalen = ", dataLength);
+
+  if (dataLength <= 0)
+    return FtpMakeResult(FTP_STATUS_OK);
+
+  size_t sent = WriteClientBuffered(&dclient, &data[0], dataLength);
+
+  return FtpMakeResult( (sent == (size_t) dataLength) ? FTP_STATUS_OK : FTP_STATUS_TRANSFER_ERROR, 0, sent );
+}
+
+/////////////////////////////////////////////
+
+FtpResult FTPClient_Generic::WriteData_P(const unsigned char * data, size_t dataLength)
+{
+#if FTP_PROGMEM_NEEDS_COPY
+
+  FTP_LOGDEBUG1("WriteData_P: datalen = ", dataLength);
+
+  if (!isConnected())
+  {
+    FTP_LOGERROR("WriteData_P: Not connected error");
+    return FtpMakeResult(FTP_STATUS_NOT_CONNECTED);
+  }
+
+  // The upload doesn't use the receive buffer, stage the flash blocks in it
+#if FTP_CLIENT_USING_ARENA
+
+  if (!AcquireArena())
+    return FtpMakeResult(FTP_STATUS_NO_MEMORY);
+
+#endif
+
+  size_t sent = 0;
+
+  _stats.bytesRequested += dataLength;
+
+  while (sent < dataLength)
+  {
+    size_t chunk = dataLength - sent;
+
+    if (chunk > bufferSize)
+      chunk = bufferSize;
+
+    memcpy_P(clientBuf, &data[sent], chunk);
+
+    size_t written = WriteClientFully(&dclient, clientBuf, chunk);
+
+    sent += written;
+
+    if (written < chunk)
+    {
+      FTP_LOGERROR3("WriteData_P: short write, sent =", sent, ", requested =", dataLength);
+      break;
+    }
+  }
+
+#if FTP_CLIENT_USING_ARENA
+  ReleaseArena();
+#endif
+
+  return FtpMakeResult( (sent == dataLength) ? FTP_STATUS_OK : FTP_STATUS_TRANSFER_ERROR, 0, sent );
+
+#else
+
+  // Memory-mapped flash (ARM, ESP32, RP2040), readable as RAM
+  return WriteData(data, dataLength);
+
+#endif
+}
+
+/////////////////////////////////////////////
+
+FtpResult FTPClient_Generic::WriteData(FTPDataProducer producer, void * context, size_t dataLength)
+{
+  FTP_LOGDEBUG1("WriteData: producer, datalen = ", dataLength);
+
+  if (!isConnected())
+  {
+    FTP_LOGERROR("WriteData: Not connected error");
+    return FtpMakeResult(FTP_STATUS_NOT_CONNECTED);
+  }
+
+  size_t sent = 0;
+
+  _stats.bytesRequested += dataLength;
+
+#if FTP_CLIENT_USING_ZERO_COPY
+
+  // The producer fills the socket TX buffer directly, as much as it has room for, then it's sent in one SEND
+  uint8_t retries = 0;
+
+  while (sent < dataLength)
+  {
+    int room = dclient.availableForWrite();
+
+    if (room <= 0)
+    {
+      // Nothing accepted. Back off to let the chip drain its TX buffer
+      _stats.stalls++;
+
+      if ( !dclient.connected() || (++retries > FTP_WRITE_MAX_RETRIES) || _deadline.expired() )
+      {
+        FTP_LOGERROR3("WriteData: write stalled, sent =", sent, ", requested =", dataLength);
+        break;
+      }
+
+      delay(FTP_WRITE_RETRY_DELAY_MS * retries);
+
+      continue;
+    }
+
+    uint16_t chunk = ( (size_t) room < dataLength - sent ) ? room : dataLength - sent;
+    uint16_t staged = dclient.writeStream(0, chunk, producer, context);
+
+    if ( (staged == 0) || !dclient.writeCommit(staged) )
+      break;
+
+    sent    += staged;
+    retries = 0;
+
+    if (staged < chunk)
+      break;
+  }
+
+  _stats.bytesSent += sent;
+
+#else
+
+  // The upload doesn't use the receive buffer, stage the produced blocks in it
+#if FTP_CLIENT_USING_ARENA
+
+  if (!AcquireArena())
+    return FtpMakeResult(FTP_STATUS_NO_MEMORY);
+
+#endif
+
+  while (sent < dataLength)
+  {
+    uint16_t chunk = (bufferSize < dataLength - sent) ? bufferSize : dataLength - sent;
+    uint16_t produced = producer(clientBuf, chunk, context);
+
+    if (produced == 0)
+      break;
+
+    size_t written = WriteClientFully(&dclient, clientBuf, produced);
+
+    sent += written;
+
+    if (written < produced)
+      break;
+  }
+
+#if FTP_CLIENT_USING_ARENA
+  ReleaseArena();
+#endif
+
+#endif
+
+  if (sent < dataLength)
+    FTP_LOGERROR3("WriteData: short write, sent =", sent, ", requested =", dataLength);
+
+  return FtpMakeResult( (sent == dataLength) ? FTP_STATUS_OK : FTP_STATUS_TRANSFER_ERROR, 0, sent );
+}
+
+/////////////////////////////////////////////
+
+FtpResult FTPClient_Generic::CloseFile ()
+{
+  FTP_LOGDEBUG(F("Close File"));
+  dclient.stop();
+
+  if (!isConnected())
+  {
+    FTP_LOGERROR("CloseFile: Not connected error");
+    return FtpMakeResult(FTP_STATUS_NOT_CONNECTED);
+  }
+
+  return GetFTPAnswer(NULL, 0, _timeouts.close);
+}
+
+/////////////////////////////////////////////
+
+FtpResult FTPClient_Generic::Write(const char * str)
+{
+  FTP_LOGDEBUG(F("Write File"));
+
+  if (!isConnected())
+  {
+    FTP_LOGERROR("Write: Not connected error");
+    return FtpMakeResult(FTP_STATUS_NOT_CONNECTED);
+  }
+
+  size_t len  = strlen(str);
+  size_t sent = WriteClientBuffered(GetDataClient(), (const unsigned char *) str, len);
+
+  return FtpMakeResult( (sent == len) ? FTP_STATUS_OK : FTP_STATUS_TRANSFER_ERROR, 0, sent );
+}
+
+/////////////////////////////////////////////
+
+FtpResult FTPClient_Generic::CloseConnection()
+{
+  client.println(COMMAND_QUIT);
+  client.stop();
+  _isConnected = false;
+  ResetKeepAlive();
+  FTP_LOGINFO(F("Connection closed"));
+
+  return FtpMakeResult(FTP_STATUS_OK);
+}
+
+/////////////////////////////////////////////
+
+FtpResult FTPClient_Generic::OpenConnection()
+{
+  FTP_LOGINFO1(F("Connecting to: "), serverAdress);
+
+  // A NOOP still in flight belongs to the previous connection
+  ResetKeepAlive();
+
+  SetConnectTimeout(client);
+
+#if FTP_CLIENT_USING_FTPS
+  #if FTP_FTPS_EXPLICIT
+  client.setPlainStart();
+  #else
+  client.setSession(&_tlsSession);
+  dclient.setSession(&_tlsSession);
+
+  // Only the data connection sends large records. The input buffer keeps the BearSSL default
+  dclient.setBufferSizes(BR_SSL_BUFSIZE_INPUT, FTP_TLS_TX_BUFFER_SIZE);
+  #endif
+#endif
+
+#if ( (ESP32) && !FTP_CLIENT_USING_ETHERNET )
+
+  if ( client.connect(serverAdress, port, Budget(_timeouts.connect)) )
+#else
+  if ( client.connect(serverAdress, port) )
+#endif
+  {
+    FTP_LOGINFO(F("Command connected"));
+  }
+  else
+  {
+    strcpy(outBuf, "Connect failed");
+    _isConnected = false;
+    isConnected();
+
+    return FtpMakeResult(FTP_STATUS_CONNECT_FAILED);
+  }
+
+  FtpResult res = GetFTPAnswer();
+
+#if (FTP_CLIENT_USING_FTPS && FTP_FTPS_EXPLICIT)
+
+  if (res)
+    res = StartTLS();
+
+#endif
+
+  if (res)
+  {
+    FTP_LOGINFO1("Send USER = ", userName);
+
+    client.print(COMMAND_USER);
+    client.println(userName);
+
+    res = GetFTPAnswer();
+  }
+
+  if (res)
+  {
+    FTP_LOGINFO1("Send PASSWORD = ", passWord);
+
+    client.print(COMMAND_PASS);
+    client.println(passWord);
+
+    res = GetFTPAnswer();
+  }
+
+#if FTP_CLIENT_USING_FTPS
+
+  if (res)
+    res = ProtectDataChannel();
+
+#endif
+
+  if (!res)
+  {
+    // Not logged in, so the control connection can't be used whatever the reply was
+    client.stop();
+    _isConnected = false;
+    isConnected();
+
+    return res;
+  }
+
+  // Once per server, kept across reconnections
+  if (res && !_featuresKnown)
+    ReadFeatures();
+
+  return res;
+}
+
+/////////////////////////////////////////////
+
+// Send FEAT and cache the capabilities. The multi-line answer doesn't fit outBuf, so it is parsed line by line :
+//   211-Features:
+//    MLST type*;size*;modify*;
+//    EPSV
+//   211 End
+// A server without FEAT (500 / 502) is left as unknown, and the client keeps its default commands
+FtpResult FTPClient_Generic::ReadFeatures()
+{
+  FTP_LOGINFO("Send FEAT");
+
+  _features       = 0;
+  _featuresKnown  = false;
+
+  client.println(COMMAND_FEATURES);
+
+  char      line[64];
+  size_t    lineLen = 0;
+
+  unsigned long _m      = millis();
+  uint32_t      budget  = Budget(_timeouts.reply);
+
+  while (millis() - _m < budget)
+  {
+    if (!client.available())
+    {
+      delay(1);
+      continue;
+    }
+
+    char thisByte = client.read();
+
+    if (thisByte == '\r')
+      continue;
+
+    if (thisByte != '\n')
+    {
+      if (lineLen < sizeof(line) - 1)
+        line[lineLen++] = thisByte;
+
+      continue;
+    }
+
+    line[lineLen] = 0;
+    lineLen       = 0;
+
+    if (line[0] == ' ')
+    {
+      ParseFeature(&line[1]);
+      continue;
+    }
+
+    // `211-Features:` opens the list, `211 End` closes it
+    if ( (strlen(line) < 4) || (line[3] == '-') )
+      continue;
+
+    _lastActivity = millis();
+
+    uint16_t code = strtoul(line, NULL, 10);
+
+    if (code != FEATURES_LIST)
+    {
+      FTP_LOGWARN1(F("ReadFeatures: FEAT not supported"), line);
+
+      return FtpMakeResult(FTP_STATUS_SERVER_ERROR, code);
+    }
+
+    _featuresKnown = true;
+
+    FTP_LOGDEBUG1(F("ReadFeatures: features ="), _features);
+
+    return FtpMakeResult(FTP_STATUS_OK, code);
+  }
+
+  FTP_LOGERROR(F("ReadFeatures: no answer"));
+
+  return FtpMakeResult(_deadline.expired() ? FTP_STATUS_DEADLINE : FTP_STATUS_TIMEOUT);
+}
+
+/////////////////////////////////////////////
+
+void FTPClient_Generic::ParseFeature(const char * feature)
+{
+  static const struct
+  {
+    const char *  name;
+    uint16_t      flag;
+  } knownFeatures[] =
+  {
+    // MLST in the FEAT list means MLSD too (RFC 3659)
+    { "MLST",         FTP_FEATURE_MLSD        },
+    { "MLSD",         FTP_FEATURE_MLSD        },
+    { "SIZE",         FTP_FEATURE_SIZE        },
+    { "MDTM",         FTP_FEATURE_MDTM        },
+    { "REST STREAM",  FTP_FEATURE_REST_STREAM },
+    { "EPSV",         FTP_FEATURE_EPSV        },
+    { "UTF8",         FTP_FEATURE_UTF8        },
+    { "HASH",         FTP_FEATURE_HASH        },
+    { "XCRC",         FTP_FEATURE_XCRC        },
+    { "MODE Z",       FTP_FEATURE_MODE_Z      },
+    { "TVFS",         FTP_FEATURE_TVFS        }
+  };
+
+  for (uint8_t i = 0; i < sizeof(knownFeatures) / sizeof(knownFeatures[0]); i++)
+  {
+    size_t len = strlen(knownFeatures[i].name);
+
+    // Whole word, parameters such as `MLST type*;size*;` or `HASH SHA-1;MD5` are ignored
+    if ( (strncasecmp(feature, knownFeatures[i].name, len) == 0) && ( (feature[len] == 0) || (feature[len] == ' ') ) )
+    {
+      _features |= knownFeatures[i].flag;
+
+      return;
+    }
+  }
+}
+
+/////////////////////////////////////////////
+
+#if FTP_CLIENT_USING_FTPS
+
+#if FTP_FTPS_EXPLICIT
+
+void FTPClient_Generic::setCACert(const char * rootCA)
+{
+  if (rootCA == NULL)
+  {
+    client.setInsecure();
+    dclient.setInsecure();
+  }
+  else
+  {
+    client.setCACert(rootCA);
+    dclient.setCACert(rootCA);
+  }
+}
+
+/////////////////////////////////////////////
+
+// Upgrade the control connection to TLS, before sending the credentials
+FtpResult FTPClient_Generic::StartTLS()
+{
+  FTP_LOGINFO("Send AUTH TLS");
+
+  client.println(COMMAND_AUTH_TLS);
+
+  FtpResult res = GetFTPAnswer();
+
+  if (!res)
+    return res;
+
+  if (res.code != AUTH_TLS_OK)
+  {
+    FTP_LOGERROR1(F("StartTLS: AUTH TLS refused"), outBuf);
+
+    return FtpMakeResult(FTP_STATUS_PROTOCOL_ERROR, res.code);
+  }
+
+  if (!client.startTLS())
+  {
+    FTP_LOGERROR(F("StartTLS: TLS handshake failed"));
+
+    client.stop();
+    _isConnected = false;
+
+    return FtpMakeResult(FTP_STATUS_CONNECT_FAILED, res.code);
+  }
+
+  return res;
+}
+
+/////////////////////////////////////////////
+
+#else
+
+void FTPClient_Generic::setTrustAnchors(const BearSSL::X509List * ta)
+{
+  if (ta == NULL)
+  {
+    client.setInsecure();
+    dclient.setInsecure();
+  }
+  else
+  {
+    client.setTrustAnchors(ta);
+    dclient.setTrustAnchors(ta);
+  }
+}
+
+/////////////////////////////////////////////
+
+#endif    // FTP_FTPS_EXPLICIT
+
+// Data connections are TLS too
+FtpResult FTPClient_Generic::ProtectDataChannel()
+{
+  FTP_LOGINFO("Send PBSZ / PROT");
+
+  client.println(COMMAND_PROTECTION_BUFFER_SIZE);
+
+  FtpResult res = GetFTPAnswer();
+
+  if (!res)
+    return res;
+
+  client.println(COMMAND_DATA_PROTECTION);
+
+  res = GetFTPAnswer();
+
+  if ( res && (res.code != COMMAND_OK) )
+  {
+    FTP_LOGERROR1(F("ProtectDataChannel: PROT P refused"), outBuf);
 
-  GetFTPAnswer();
+    return FtpMakeResult(FTP_STATUS_PROTOCOL_ERROR, res.code);
+  }
 
-  FTP_LOGINFO1("Send PASSWORD = ", passWord);
+  return res;
+}
 
-  client.print(COMMAND_PASS);
-  client.println(passWord);
+/////////////////////////////////////////////
 
-  GetFTPAnswer();
-}
+#endif    // FTP_CLIENT_USING_FTPS
 
 /////////////////////////////////////////////
 
-void FTPClient_Generic::RenameFile(const char* from, const char* to)
+FtpResult FTPClient_Generic::RenameFile(const char* from, const char* to)
 {
   FTP_LOGINFO("Send RNFR");
 
   if (!isConnected())
   {
     FTP_LOGERROR("RenameFile: Not connected error");
-    return;
+    return FtpMakeResult(FTP_STATUS_NOT_CONNECTED);
   }
 
   client.print(COMMAND_RENAME_FILE_FROM);
   client.println(from);
 
-  GetFTPAnswer();
+  FtpResult res = GetFTPAnswer();
+
+  if (!res)
+    return res;
 
   FTP_LOGINFO("Send RNTO");
 
   client.print(COMMAND_RENAME_FILE_TO);
   client.println(to);
 
-  GetFTPAnswer();
+  return GetFTPAnswer();
 }
 
 /////////////////////////////////////////////
 
-void FTPClient_Generic::NewFile (const char* fileName)
+FtpResult FTPClient_Generic::NewFile (const char* fileName)
 {
   FTP_LOGINFO("Send STOR");
 
   if (!isConnected())
   {
     FTP_LOGERROR("NewFile: Not connected error");
-    return;
+    return FtpMakeResult(FTP_STATUS_NOT_CONNECTED);
   }
 
   client.print(COMMAND_FILE_UPLOAD);
   client.println(fileName);
 
-  GetFTPAnswer();
+#if FTP_CLIENT_USING_ACTIVE_MODE
+  return AcceptDataConnection(GetFTPAnswer());
+#else
+  return CheckDataReply(GetFTPAnswer());
+#endif
 }
 
 /////////////////////////////////////////////
 
-void FTPClient_Generic::InitFile(const char* type)
+// `227 Entering Passive Mode`, data connection to the address and port given by the server
+FtpResult FTPClient_Generic::EnterPassiveMode()
 {
-  FTP_LOGINFO1("Send TYPE", type);
-
-  if (!isConnected())
-  {
-    FTP_LOGERROR("InitFile: Not connected error");
-    return;
-  }
-
   FTP_LOGINFO("Send PASV");
 
   client.println(COMMAND_PASSIVE_MODE);
-  GetFTPAnswer();
+  FtpResult res = GetFTPAnswer();
 
   // KH
   FTP_LOGDEBUG1("outBuf =", outBuf);
@@ -345,18 +1357,42 @@ void FTPClient_Generic::InitFile(const char* type)
   char *tmpPtr;
   //FTP_LOGDEBUG1("outBuf =", strtol(outBuf, &tmpPtr, 10 ));
 
+  uint8_t retries = 0;
+
   while (strtol(outBuf, &tmpPtr, 10 ) != ENTERING_PASSIVE_MODE)
   {
+    if ( !res || _deadline.expired() )
+    {
+      FTP_LOGERROR1("EnterPassiveMode: PASV failed =", outBuf);
+      return res ? FtpMakeResult(FTP_STATUS_DEADLINE, res.code) : res;
+    }
+
+    // Unexpected but not an error, such as a late reply to a previous command
+    if (++retries > FTP_PASV_MAX_RETRIES)
+    {
+      FTP_LOGERROR1("EnterPassiveMode: no 227 reply =", outBuf);
+      return FtpMakeResult(FTP_STATUS_PROTOCOL_ERROR, res.code);
+    }
+
     client.println(COMMAND_PASSIVE_MODE);
-    GetFTPAnswer();
+    res = GetFTPAnswer();
     FTP_LOGDEBUG1("outBuf =", outBuf);
-    delay(1000);
+    delay(Budget(1000));
   }
 
   // Test to know which format
   // 227 Entering Passive Mode (192,168,2,112,157,218)
   // 227 Entering Passive Mode (4043483328, port 55600)
-  char *passiveIP = strchr(outBuf, '(') + 1;
+  char *passiveIP = strchr(outBuf, '(');
+
+  if (passiveIP == NULL)
+  {
+    FTP_LOGERROR1(F("Bad PASV Answer"), outBuf);
+
+    return FtpMakeResult(FTP_STATUS_PROTOCOL_ERROR, ENTERING_PASSIVE_MODE);
+  }
+
+  passiveIP++;
   //FTP_LOGDEBUG1("passiveIP =", atoi(passiveIP));
 
   if (atoi(passiveIP) <= 0xFF)
@@ -375,7 +1411,7 @@ void FTPClient_Generic::InitFile(const char* type)
         FTP_LOGDEBUG(F("Bad PASV Answer"));
 
         CloseConnection();
-        return;
+        return FtpMakeResult(FTP_STATUS_PROTOCOL_ERROR, ENTERING_PASSIVE_MODE);
       }
 
       array_pasv[i] = atoi(tStr);
@@ -408,261 +1444,617 @@ void FTPClient_Generic::InitFile(const char* type)
     _dataPort = strtol( ptr, &tmpPtr, 10 );
   }
 
+  return FtpMakeResult(FTP_STATUS_OK, ENTERING_PASSIVE_MODE);
+}
+
+/////////////////////////////////////////////
+
+// `229 Entering Extended Passive Mode (|||port|)`, data connection to the control connection address.
+// Nothing else to parse, and still right when the server is behind NAT
+FtpResult FTPClient_Generic::EnterExtendedPassiveMode()
+{
+  FTP_LOGINFO("Send EPSV");
+
+  client.println(COMMAND_EXTENDED_PASSIVE_MODE);
+
+  FtpResult res = GetFTPAnswer();
+
+  if (!res)
+    return res;
+
+  const char * portStr = strstr(outBuf, "(|||");
+
+  if ( (res.code != ENTERING_EXTENDED_PASSIVE_MODE) || (portStr == NULL) )
+  {
+    FTP_LOGERROR1(F("Bad EPSV Answer"), outBuf);
+
+    return FtpMakeResult(FTP_STATUS_PROTOCOL_ERROR, res.code);
+  }
+
+  _dataAddress  = client.remoteIP();
+  _dataPort     = strtoul(portStr + 4, NULL, 10);
+
+  return res;
+}
+
+/////////////////////////////////////////////
+
+FtpResult FTPClient_Generic::InitFile(const char* type)
+{
+  FTP_LOGINFO1("Send TYPE", type);
+
+  if (!isConnected())
+  {
+    FTP_LOGERROR("InitFile: Not connected error");
+    return FtpMakeResult(FTP_STATUS_NOT_CONNECTED);
+  }
+
+  // New transfer, restart the write accounting
+  memset(&_stats, 0, sizeof(_stats));
+
+#if FTP_CLIENT_USING_ACTIVE_MODE
+
+  if (_dataServer != NULL)
+  {
+    FtpResult res = SendActivePort();
+
+    if (!res)
+      return res;
+
+    client.println(type);
+
+    return GetFTPAnswer();
+  }
+
+#endif
+
+  FtpResult res = hasFeature(FTP_FEATURE_EPSV) ? EnterExtendedPassiveMode() : EnterPassiveMode();
+
+  if (!res)
+    return res;
+
   FTP_LOGINFO3(F("_dataAddress: "), _dataAddress, F(", Data port: "), _dataPort);
 
+  SetConnectTimeout(dclient);
+
 #if ( (ESP32) && !FTP_CLIENT_USING_ETHERNET )
 
-  if (dclient.connect(_dataAddress, _dataPort, timeout))
+  if (dclient.connect(_dataAddress, _dataPort, Budget(_timeouts.connect)))
 #else
   if (dclient.connect(_dataAddress, _dataPort))
 #endif
   {
     FTP_LOGDEBUG(F("Data connection established"));
   }
+  else
+  {
+    FTP_LOGERROR3(F("InitFile: data connection failed to"), _dataAddress, F(", port"), _dataPort);
+
+    return FtpMakeResult(FTP_STATUS_CONNECT_FAILED);
+  }
 
   client.println(type);
-  GetFTPAnswer();
+  return GetFTPAnswer();
+}
+
+/////////////////////////////////////////////
+
+#if FTP_CLIENT_USING_ACTIVE_MODE
+
+void FTPClient_Generic::setActiveMode(theFTPServer& dataServer, IPAddress localIP, uint16_t dataPort, bool useEPRT)
+{
+  _dataServer = &dataServer;
+  _localIP    = localIP;
+  _activePort = dataPort;
+  _useEPRT    = useEPRT;
+
+  _dataServer->begin();
+}
+
+/////////////////////////////////////////////
+
+// Tell the server where to connect for the next transfer. Replaces PASV and its reply parsing
+FtpResult FTPClient_Generic::SendActivePort()
+{
+  // Drop a leftover connection of an aborted transfer
+  dclient.stop();
+
+  char portCmd[40];
+
+  if (_useEPRT)
+  {
+    FTP_LOGINFO("Send EPRT");
+
+    snprintf(portCmd, sizeof(portCmd), "|1|%u.%u.%u.%u|%u|", _localIP[0], _localIP[1], _localIP[2], _localIP[3],
+             _activePort);
+    client.print(COMMAND_EXTENDED_ACTIVE_MODE);
+  }
+  else
+  {
+    FTP_LOGINFO("Send PORT");
+
+    snprintf(portCmd, sizeof(portCmd), "%u,%u,%u,%u,%u,%u", _localIP[0], _localIP[1], _localIP[2], _localIP[3],
+             _activePort >> 8, _activePort & 0xFF);
+    client.print(COMMAND_ACTIVE_MODE);
+  }
+
+  client.println(portCmd);
+
+  FtpResult res = GetFTPAnswer();
+
+  if ( res && (res.code != COMMAND_OK) )
+  {
+    FTP_LOGERROR1(F("SendActivePort: bad answer"), outBuf);
+
+    return FtpMakeResult(FTP_STATUS_PROTOCOL_ERROR, res.code);
+  }
+
+  return res;
+}
+
+/////////////////////////////////////////////
+
+// After the preliminary reply of STOR / APPE / RETR / LIST / MLSD, wait for the server to connect to
+// the data port. res is that reply, returned unchanged on success or in passive mode
+FtpResult FTPClient_Generic::AcceptDataConnection(FtpResult res)
+{
+  if ( !res || (_dataServer == NULL) )
+    return res;
+
+  unsigned long _m      = millis();
+  uint32_t      budget  = Budget(_timeouts.connect);
+
+  while (millis() - _m < budget)
+  {
+    // accept() and not available(), as the server sends nothing before STOR data
+    theFTPClient cli = _dataServer->accept();
+
+    if (cli)
+    {
+      FTP_LOGDEBUG(F("Data connection accepted"));
+      dclient = cli;
+
+      return res;
+    }
+
+    delay(1);
+  }
+
+  FTP_LOGERROR1(F("AcceptDataConnection: no connection on port"), _activePort);
+
+  return FtpMakeResult(_deadline.expired() ? FTP_STATUS_DEADLINE : FTP_STATUS_CONNECT_FAILED, res.code);
 }
 
 /////////////////////////////////////////////
 
-void FTPClient_Generic::AppendFile (const char* fileName)
+#endif    // FTP_CLIENT_USING_ACTIVE_MODE
+
+FtpResult FTPClient_Generic::AppendFile (const char* fileName)
 {
   FTP_LOGINFO("Send APPE");
 
   if (!isConnected())
   {
     FTP_LOGERROR("AppendFile: Not connected error");
-    return;
+    return FtpMakeResult(FTP_STATUS_NOT_CONNECTED);
   }
 
   client.print(COMMAND_APPEND_FILE);
   client.println(fileName);
-  GetFTPAnswer();
+
+#if FTP_CLIENT_USING_ACTIVE_MODE
+  return AcceptDataConnection(GetFTPAnswer());
+#else
+  return CheckDataReply(GetFTPAnswer());
+#endif
 }
 
 /////////////////////////////////////////////
 
-void FTPClient_Generic::ChangeWorkDir(const char * dir)
+FtpResult FTPClient_Generic::ChangeWorkDir(const char * dir)
 {
   FTP_LOGINFO("Send CWD");
 
   if (!isConnected())
   {
     FTP_LOGERROR("ChangeWorkDir: Not connected error");
-    return;
+    return FtpMakeResult(FTP_STATUS_NOT_CONNECTED);
   }
 
   client.print(COMMAND_CURRENT_WORKING_DIR);
   client.println(dir);
-  GetFTPAnswer();
+  return GetFTPAnswer();
 }
 
 /////////////////////////////////////////////
 
-void FTPClient_Generic::DeleteFile(const char * file)
+FtpResult FTPClient_Generic::DeleteFile(const char * file)
 {
   FTP_LOGINFO("Send DELE");
 
   if (!isConnected())
   {
     FTP_LOGERROR("DeleteFile: Not connected error");
-    return;
+    return FtpMakeResult(FTP_STATUS_NOT_CONNECTED);
   }
 
   client.print(COMMAND_DELETE_FILE);
   client.println(file);
-  GetFTPAnswer();
+  return GetFTPAnswer();
 }
 
 /////////////////////////////////////////////
 
-void FTPClient_Generic::MakeDir(const char * dir)
+FtpResult FTPClient_Generic::MakeDir(const char * dir)
 {
   FTP_LOGINFO("Send MKD");
 
   if (!isConnected())
   {
     FTP_LOGERROR("MakeDir: Not connected error");
-    return;
+    return FtpMakeResult(FTP_STATUS_NOT_CONNECTED);
   }
 
   client.print(COMMAND_MAKE_DIR);
   client.println(dir);
 
-  GetFTPAnswer();
+  return GetFTPAnswer();
 }
 
 /////////////////////////////////////////////
 
-void FTPClient_Generic::RemoveDir(const char * dir)
+FtpResult FTPClient_Generic::RemoveDir(const char * dir)
 {
   FTP_LOGINFO("Send RMD");
 
   if (!isConnected())
   {
     FTP_LOGERROR("RemoveDir: Not connected error");
-    return;
+    return FtpMakeResult(FTP_STATUS_NOT_CONNECTED);
   }
 
   client.print(COMMAND_REMOVE_DIR);
   client.println(dir);
 
-  GetFTPAnswer();
+  return GetFTPAnswer();
 }
 
 /////////////////////////////////////////////
 
-void FTPClient_Generic::ContentList(const char * dir, String * list)
+FtpResult FTPClient_Generic::ReceiveListing(const __FlashStringHelper * command, const char * dir,
+                                            FTPLineCallback onLine, void * context, uint16_t maxLines)
 {
-  char _resp[ sizeof(outBuf) ];
   uint16_t _b = 0;
 
-  FTP_LOGINFO("Send MLSD");
-
   if (!isConnected())
   {
-    FTP_LOGERROR("ContentList: Not connected error");
-    return;
+    FTP_LOGERROR("ReceiveListing: Not connected error");
+    return FtpMakeResult(FTP_STATUS_NOT_CONNECTED);
   }
 
-  client.print(COMMAND_LIST_DIR_STANDARD);
-  client.println(dir);
-  GetFTPAnswer(_resp);
-
-  // Convert char array to string to manipulate and find response size
-  // each server reports it differently, TODO = FEAT
-  //String resp_string = _resp;
-  //resp_string.substring(resp_string.lastIndexOf('matches')-9);
-  //FTP_LOGDEBUG(resp_string);
+  FtpResult res = StartDataTransfer(command, dir);
 
-  unsigned long _m = millis();
+  if (!res)
+    return res;
 
-  while ( !dclient.available() && millis() < _m + timeout)
-    delay(1);
+#if FTP_CLIENT_USING_ARENA
+  char * line = (char *) _arena->alloc(FTP_LINE_BUFFER_SIZE);
 
-  while (dclient.available())
+  // Not an empty listing
+  if (line == NULL)
   {
-    if ( _b < 128 )
-    {
-      list[_b] = dclient.readStringUntil('\n');
-      //FTP_LOGDEBUG(String(_b) + ":" + list[_b]);
-      _b++;
-    }
+    FTP_LOGERROR(F("ReceiveListing: arena too small for the line buffer"));
+
+    return EndDataTransfer(FTP_STATUS_NO_MEMORY, 0);
   }
+#else
+  char line[FTP_LINE_BUFFER_SIZE];
+#endif
+
+  _b = ReceiveLines(line, onLine, context, maxLines);
+
+  FTP_LOGDEBUG1("ReceiveListing: lines =", _b);
+
+  return EndDataTransfer(FTP_STATUS_OK, _b);
 }
 
 /////////////////////////////////////////////
 
-void FTPClient_Generic::ContentListWithListCommand(const char * dir, String * list)
+FtpResult FTPClient_Generic::ContentList(const char * dir, FTPLineCallback onLine, void * context, uint16_t maxLines)
 {
-  char _resp[ sizeof(outBuf) ];
-  uint16_t _b = 0;
+  // Server known not to have MLSD, such as vsftpd : LIST instead of a 500 answer
+  if ( _featuresKnown && !hasFeature(FTP_FEATURE_MLSD) )
+  {
+    FTP_LOGINFO("Send LIST, no MLSD");
+
+    return ReceiveListing(COMMAND_LIST_DIR, dir, onLine, context, maxLines);
+  }
+
+  FTP_LOGINFO("Send MLSD");
+
+  return ReceiveListing(COMMAND_LIST_DIR_STANDARD, dir, onLine, context, maxLines);
+}
 
+/////////////////////////////////////////////
+
+FtpResult FTPClient_Generic::ContentListWithListCommand(const char * dir, FTPLineCallback onLine, void * context,
+                                                        uint16_t maxLines)
+{
   FTP_LOGINFO("Send LIST");
 
+  return ReceiveListing(COMMAND_LIST_DIR, dir, onLine, context, maxLines);
+}
+
+/////////////////////////////////////////////
+
+FtpResult FTPClient_Generic::ContentList(const char * dir, char * list, uint16_t lineSize, uint16_t maxLines)
+{
+  if ( (list == NULL) || (lineSize == 0) )
+    return FtpMakeResult(FTP_STATUS_PROTOCOL_ERROR);
+
+  FTPLineBuffer lb = { list, lineSize };
+
+  return ContentList(dir, StoreLineBuffer, &lb, maxLines);
+}
+
+/////////////////////////////////////////////
+
+FtpResult FTPClient_Generic::ContentListWithListCommand(const char * dir, char * list, uint16_t lineSize,
+                                                        uint16_t maxLines)
+{
+  if ( (list == NULL) || (lineSize == 0) )
+    return FtpMakeResult(FTP_STATUS_PROTOCOL_ERROR);
+
+  FTPLineBuffer lb = { list, lineSize };
+
+  return ContentListWithListCommand(dir, StoreLineBufferName, &lb, maxLines);
+}
+
+/////////////////////////////////////////////
+
+#if FTP_CLIENT_USING_STRING
+
+FtpResult FTPClient_Generic::ContentList(const char * dir, String * list)
+{
+  return ContentList(dir, StoreLine, list, 128);
+}
+
+/////////////////////////////////////////////
+
+FtpResult FTPClient_Generic::ContentListWithListCommand(const char * dir, String * list)
+{
+  return ContentListWithListCommand(dir, StoreLineName, list, 128);
+}
+
+/////////////////////////////////////////////
+
+FtpResult FTPClient_Generic::DownloadString(const char * filename, String &str)
+{
+  FTP_LOGINFO("Send RETR");
+
   if (!isConnected())
   {
-    FTP_LOGERROR("ContentListWithListCommand: Not connected error");
-    return;
+    FTP_LOGERROR("DownloadString: Not connected error");
+    return FtpMakeResult(FTP_STATUS_NOT_CONNECTED);
   }
 
-  client.print(COMMAND_LIST_DIR);
-  client.println(dir);
+  FtpResult res = StartDataTransfer(COMMAND_DOWNLOAD, filename);
 
-  GetFTPAnswer(_resp);
+  if (!res)
+    return res;
 
-  // Convert char array to string to manipulate and find response size
-  // each server reports it differently, TODO = FEAT
-  //String resp_string = _resp;
-  //resp_string.substring(resp_string.lastIndexOf('matches')-9);
-  //FTP_LOGDEBUG(resp_string);
+  size_t expected = ParseTransferSize(outBuf);
+  size_t received = 0;
 
-  unsigned long _m = millis();
+  if (expected > 0)
+    str.reserve(str.length() + expected);
 
-  while ( !dclient.available() && millis() < _m + timeout)
-    delay(1);
+  unsigned long _m = millis();
 
-  while (dclient.available())
+  while ( WaitForData(received, expected, _m) )
   {
-    if ( _b < 128 )
-    {
-      String tmp = dclient.readStringUntil('\n');
-      list[_b] = tmp.substring(tmp.lastIndexOf(" ") + 1, tmp.length());
+    // Keep one byte to NUL-terminate the chunk
+    size_t toRead = GetDataClient()->available();
 
-      //FTP_LOGDEBUG(String(_b) + ":" + tmp);
+    if (toRead > bufferSize - 1)
+      toRead = bufferSize - 1;
 
-      _b++;
-    }
+    int len = GetDataClient()->read(clientBuf, toRead);
+
+    if (len <= 0)
+      continue;
+
+    clientBuf[len] = 0;
+    str += (const char *) clientBuf;
+
+    received += len;
   }
+
+  return EndDataTransfer( ( (expected > 0) && (received < expected) ) ? FTP_STATUS_TRANSFER_ERROR : FTP_STATUS_OK,
+                          received );
+}
+
+/////////////////////////////////////////////
+
+#endif    // FTP_CLIENT_USING_STRING
+
+FtpResult FTPClient_Generic::DownloadString(const char * filename, char * buf, size_t bufSize)
+{
+  // Room for at least one byte and the NUL
+  if ( (buf == NULL) || (bufSize < 2) )
+    return FtpMakeResult(FTP_STATUS_PROTOCOL_ERROR);
+
+  // Keep one byte to NUL-terminate. bytes is 0 if the transfer didn't start
+  FtpResult res = DownloadFile(filename, (unsigned char *) buf, bufSize - 1);
+
+  buf[res.bytes] = 0;
+
+  return res;
 }
 
 /////////////////////////////////////////////
 
-void FTPClient_Generic::DownloadString(const char * filename, String &str)
+FtpResult FTPClient_Generic::DownloadFile(const char * filename, unsigned char * buf, size_t length, bool printUART )
 {
   FTP_LOGINFO("Send RETR");
 
+  // Nothing could be read, and the wait below would only end on the server closing the data connection
+  if ( ( (buf == NULL) && !printUART ) || (length == 0) )
+  {
+    FTP_LOGERROR("DownloadFile: empty buffer");
+    return FtpMakeResult(FTP_STATUS_PROTOCOL_ERROR);
+  }
+
   if (!isConnected())
-    return;
+  {
+    FTP_LOGERROR("DownloadFile: Not connected error");
+    return FtpMakeResult(FTP_STATUS_NOT_CONNECTED);
+  }
 
-  client.print(COMMAND_DOWNLOAD);
-  client.println(filename);
+  FtpResult res = StartDataTransfer(COMMAND_DOWNLOAD, filename);
 
-  char _resp[ sizeof(outBuf) ];
-  GetFTPAnswer(_resp);
+  if (!res)
+    return res;
+
+  size_t reported = ParseTransferSize(outBuf);
+  size_t expected = reported;
+  size_t received = 0;
+
+  if ( (expected == 0) || (expected > length) )
+    expected = length;
 
   unsigned long _m = millis();
 
-  while ( !GetDataClient()->available() && millis() < _m + timeout)
-    delay(1);
+  while ( WaitForData(received, expected, _m) )
+  {
+    size_t toRead = dclient.available();
+
+    if (toRead > expected - received)
+      toRead = expected - received;
+
+    if ( !printUART )
+    {
+      int len = dclient.read(&buf[received], toRead);
+
+      if (len > 0)
+        received += len;
+    }
+    else
+    {
+      // Only print to debug port, don't store
+      if (toRead > bufferSize)
+        toRead = bufferSize;
+
+      int len = dclient.read(clientBuf, toRead);
+
+      if (len > 0)
+      {
+        if (_FTP_LOGLEVEL_ > 3)
+          FTP_DEBUG_OUTPUT.write(clientBuf, len);
+
+        received += len;
+      }
+    }
+  }
 
-  while ( GetDataClient()->available() )
+  FtpStatus status = FTP_STATUS_OK;
+
+  if ( dclient.available() || (reported > length) )
+  {
+    FTP_LOGWARN1("DownloadFile: buffer too small, received =", received);
+    status = FTP_STATUS_TRANSFER_ERROR;
+  }
+  else if ( (reported > 0) && (received < reported) )
   {
-    str += GetDataClient()->readString();
+    status = FTP_STATUS_TRANSFER_ERROR;
   }
+
+  FTP_LOGDEBUG1("DownloadFile: total received =", received);
+
+  return EndDataTransfer(status, received);
 }
 
 /////////////////////////////////////////////
 
-void FTPClient_Generic::DownloadFile(const char * filename, unsigned char * buf, size_t length, bool printUART )
+FtpResult FTPClient_Generic::DownloadFile(const char * filename, FTPDownloadSink& sink, size_t fileSize)
 {
   FTP_LOGINFO("Send RETR");
 
   if (!isConnected())
   {
     FTP_LOGERROR("DownloadFile: Not connected error");
-    return;
+    return FtpMakeResult(FTP_STATUS_NOT_CONNECTED);
   }
 
-  client.print(COMMAND_DOWNLOAD);
-  client.println(filename);
+  FtpResult res = StartDataTransfer(COMMAND_DOWNLOAD, filename);
 
-  char _resp[ sizeof(outBuf) ];
-  GetFTPAnswer(_resp);
+  if (!res)
+    return res;
 
-  char _buf[2];
+  // Size from the `150` reply, so sinks such as Update can be sized upfront
+  if (fileSize == 0)
+    fileSize = ParseTransferSize(outBuf);
 
-  unsigned long _m = millis();
+  if (!sink.begin(fileSize))
+  {
+    FTP_LOGERROR("DownloadFile: sink begin error");
 
-  while ( !dclient.available() && millis() < _m + timeout)
-    delay(1);
+    return EndDataTransfer(FTP_STATUS_TRANSFER_ERROR, 0);
+  }
+
+  bool    success = true;
+  size_t  total   = 0;
+
+  unsigned long _m = millis();
 
-  while (dclient.available())
+  // Stream until EOF or fileSize, so sink writes (flash erase / program) can take longer
+  // than the time the RX buffer stays non-empty
+  while ( success && WaitForData(total, fileSize, _m) )
   {
-    if ( !printUART )
-      dclient.readBytes(buf, length);
-    else
+    size_t toRead = dclient.available();
+
+    if (toRead > bufferSize)
+      toRead = bufferSize;
+
+    if ( (fileSize > 0) && (toRead > fileSize - total) )
+      toRead = fileSize - total;
+
+    int len = dclient.read(clientBuf, toRead);
+
+    if (len <= 0)
+      continue;
+
+    if (sink.write(clientBuf, len) != (size_t) len)
     {
-      for (size_t _b = 0; _b < length; _b++ )
-      {
-        dclient.readBytes(_buf, 1);
-        //FTP_LOGDEBUG0(_buf[0]);
-      }
+      FTP_LOGERROR1("DownloadFile: sink write error, received =", total);
+      success = false;
+      break;
     }
+
+    total += len;
+
+    // Don't count slow sink writes (flash erase) as network idle time
+    _m = millis();
   }
+
+  if ( success && (fileSize > 0) && (total != fileSize) )
+  {
+    FTP_LOGERROR3("DownloadFile: size mismatch, expected =", fileSize, ", received =", total);
+    success = false;
+  }
+
+  FTP_LOGDEBUG1("DownloadFile: total received =", total);
+
+  if (!sink.end(success))
+    success = false;
+
+  return EndDataTransfer(success ? FTP_STATUS_OK : FTP_STATUS_TRANSFER_ERROR, total);
 }
 
 /////////////////////////////////////////////
 
+#if !FTP_CLIENT_USING_STRING
+  #undef String
+#endif
+
 #endif    // FTPCLIENT_GENERIC_IMPL_H
@@ -0,0 +1,110 @@
+/****************************************************************************************************************************
+  FTPClient_Generic_OTA.h
+
+  FTP Client for Generic boards using SD, FS, etc.
+
+  Based on and modified from
+
+  1) esp32_ftpclient Library         https://github.com/ldab/ESP32_FTPClient
+
+  Built by Khoi Hoang https://github.com/khoih-prog/FTPClient_Generic
+
+  Version: 1.6.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0   K Hoang      11/05/2022 Initial porting and coding to support many more boards, using WiFi or Ethernet
+  1.1.0   K Hoang      13/05/2022 Add support to Teensy 4.1 using QNEthernet or NativeEthernet
+  1.2.0   K Hoang      14/05/2022 Add support to other FTP Servers. Fix bug
+  1.2.1   K Hoang      14/05/2022 Auto detect server response type in PASV mode
+  1.3.0   K Hoang      16/05/2022 Fix uploading issue of large files for WiFi, QNEthernet
+  1.4.0   K Hoang      05/11/2022 Add support to ESP32/ESP8266 using Ethernet W5x00 or ENC28J60
+  1.5.0   K Hoang      20/01/2023 Add support to RP2040W using `arduino-pico` core
+  1.5.0   K Hoang      20/01/2023 Add support to Ethernet W6100 using Ethernet_Generic library
+ *****************************************************************************************************************************/
+
+// Optional, include after FTPClient_Generic.h / FTPClient_Generic.hpp to download OTA firmware
+// directly into the platform update partition
+
+#pragma once
+
+#ifndef FTPCLIENT_GENERIC_OTA_H
+#define FTPCLIENT_GENERIC_OTA_H
+
+#include "FTPClient_Generic_Sink.h"
+
+/////////////////////////////////////////////
+
+#if (ESP32)
+  #include <Update.h>
+  #define FTP_CLIENT_HAS_UPDATER      true
+#elif (ESP8266 || ARDUINO_ARCH_RP2040) && !defined(ARDUINO_ARCH_MBED)
+  // arduino-pico `Updater` stages the image in LittleFS and commits it with PicoOTA
+  #include <Updater.h>
+  #define FTP_CLIENT_HAS_UPDATER      true
+#else
+  #define FTP_CLIENT_HAS_UPDATER      false
+#endif
+
+/////////////////////////////////////////////
+
+#if FTP_CLIENT_HAS_UPDATER
+
+// Sink using the core `Update` object (ESP32, ESP8266, RP2040 arduino-pico). Data is passed straight
+// to Update, which already stages it into flash sectors
+class FTPOTASink : public FTPDownloadSink
+{
+  public:
+
+    // totalSize is 0 if neither the caller nor the server gave the file size
+    bool begin(size_t totalSize)
+    {
+      if (totalSize == 0)
+      {
+#if defined(UPDATE_SIZE_UNKNOWN)
+        totalSize = UPDATE_SIZE_UNKNOWN;
+#elif (ESP8266)
+        // Update.begin(0) fails on ESP8266. Reserve all the free sketch space instead
+        totalSize = (ESP.getFreeSketchSpace() - 0x1000) & 0xFFFFF000;
+#else
+        FTP_LOGERROR(F("FTPOTASink: file size needed, pass it to DownloadFile()"));
+
+        return false;
+#endif
+      }
+
+      if (!Update.begin(totalSize))
+      {
+        FTP_LOGERROR1(F("FTPOTASink: Update.begin error, size ="), totalSize);
+
+        return false;
+      }
+
+      return true;
+    }
+
+    size_t write(const uint8_t * data, size_t len)
+    {
+      return Update.write((uint8_t *) data, len);
+    }
+
+    bool end(bool success)
+    {
+      if (!success)
+      {
+#if (ESP32)
+        Update.abort();
+#endif
+
+        return false;
+      }
+
+      return Update.end(true);
+    }
+};
+
+#endif    // FTP_CLIENT_HAS_UPDATER
+
+/////////////////////////////////////////////
+
+#endif    // FTPCLIENT_GENERIC_OTA_H
@@ -0,0 +1,272 @@
+/****************************************************************************************************************************
+  FTPClient_Generic_Pool.h
+
+  FTP Client for Generic boards using SD, FS, etc.
+
+  Based on and modified from
+
+  1) esp32_ftpclient Library         https://github.com/ldab/ESP32_FTPClient
+
+  Built by Khoi Hoang https://github.com/khoih-prog/FTPClient_Generic
+
+  Version: 1.6.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0   K Hoang      11/05/2022 Initial porting and coding to support many more boards, using WiFi or Ethernet
+  1.1.0   K Hoang      13/05/2022 Add support to Teensy 4.1 using QNEthernet or NativeEthernet
+  1.2.0   K Hoang      14/05/2022 Add support to other FTP Servers. Fix bug
+  1.2.1   K Hoang      14/05/2022 Auto detect server response type in PASV mode
+  1.3.0   K Hoang      16/05/2022 Fix uploading issue of large files for WiFi, QNEthernet
+  1.4.0   K Hoang      05/11/2022 Add support to ESP32/ESP8266 using Ethernet W5x00 or ENC28J60
+  1.5.0   K Hoang      20/01/2023 Add support to RP2040W using `arduino-pico` core
+  1.5.0   K Hoang      20/01/2023 Add support to Ethernet W6100 using Ethernet_Generic library
+ *****************************************************************************************************************************/
+
+// Optional, include after FTPClient_Generic.h / FTPClient_Generic.hpp to keep logged-in sessions
+// to several servers (primary, backup, archive, etc.) and reuse them between uploads
+
+#pragma once
+
+#ifndef FTPCLIENT_GENERIC_POOL_H
+#define FTPCLIENT_GENERIC_POOL_H
+
+#include "FTPClient_Generic.hpp"
+
+/////////////////////////////////////////////
+
+// Idle sessions without a reply for longer than this are checked with NOOP before being leased.
+// Maintain() sends its keepalive NOOP at half this interval, so that kept-alive sessions skip the check
+#ifndef FTP_POOL_KEEPALIVE_MS
+  #define FTP_POOL_KEEPALIVE_MS       30000UL
+#endif
+
+// Each open session uses one control socket, plus one data socket during transfers
+#define FTP_POOL_SOCKETS_PER_SESSION  2
+
+/////////////////////////////////////////////
+
+template<uint8_t MAX_SESSIONS>
+class FTPClient_Generic_Pool
+{
+  public:
+
+    // socketBudget : max number of sockets the pool may use. Default lets all sessions be open
+    FTPClient_Generic_Pool(uint8_t socketBudget = MAX_SESSIONS * FTP_POOL_SOCKETS_PER_SESSION)
+    {
+      _maxOpen = socketBudget / FTP_POOL_SOCKETS_PER_SESSION;
+
+      if (_maxOpen > MAX_SESSIONS)
+        _maxOpen = MAX_SESSIONS;
+
+      for (uint8_t i = 0; i < MAX_SESSIONS; i++)
+      {
+        _slots[i].open      = false;
+        _slots[i].leased    = false;
+        _slots[i].lastUsed  = 0;
+      }
+    }
+
+    /////////////////////////////////////////////
+
+    // Returns a connected and logged-in session, or NULL if it can't connect or all sessions are leased.
+    // Must be given back with Return()
+    FTPClient_Generic* Lease(char* server, uint16_t port, char* user, char* pass)
+    {
+      // 1. Idle session to the same server
+      for (uint8_t i = 0; i < MAX_SESSIONS; i++)
+      {
+        if ( !_slots[i].open || _slots[i].leased || !_sessions[i].IsSameServer(server, port, user) )
+          continue;
+
+        // Sessions kept alive by Maintain() have a recent reply and skip the NOOP round trip
+        if ( (millis() - _sessions[i].LastReplyTime() > FTP_POOL_KEEPALIVE_MS) && !_sessions[i].Noop() )
+        {
+          FTP_LOGWARN1(F("Pool: stale session dropped, slot ="), i);
+          Close(i);
+
+          continue;
+        }
+
+        FTP_LOGDEBUG1(F("Pool: reuse session, slot ="), i);
+
+        return Take(i);
+      }
+
+      // 2. Free slot, or evict the least recently used idle session
+      int slot = -1;
+
+      if (OpenCount() < _maxOpen)
+      {
+        for (uint8_t i = 0; (i < MAX_SESSIONS) && (slot < 0); i++)
+        {
+          if (!_slots[i].open)
+            slot = i;
+        }
+      }
+
+      if (slot < 0)
+      {
+        slot = LeastRecentlyUsed();
+
+        if (slot < 0)
+        {
+          FTP_LOGERROR(F("Pool: all sessions leased"));
+
+          return NULL;
+        }
+
+        FTP_LOGINFO1(F("Pool: evict session, slot ="), slot);
+        Close(slot);
+      }
+
+      // 3. New session
+      _sessions[slot].SetServer(server, port, user, pass);
+      _sessions[slot].OpenConnection();
+
+      if (!_sessions[slot].isConnected())
+      {
+        FTP_LOGERROR1(F("Pool: can't connect to"), server);
+        _sessions[slot].CloseConnection();
+
+        return NULL;
+      }
+
+      _sessions[slot].setKeepAlive(FTP_POOL_KEEPALIVE_MS / 2);
+      _slots[slot].open = true;
+
+      return Take(slot);
+    }
+
+    /////////////////////////////////////////////
+
+    FTPClient_Generic* Lease(char* server, char* user, char* pass)
+    {
+      return Lease(server, FTP_PORT, user, pass);
+    }
+
+    /////////////////////////////////////////////
+
+    // reusable = false to close the session, such as after a protocol error
+    void Return(FTPClient_Generic* session, bool reusable = true)
+    {
+      for (uint8_t i = 0; i < MAX_SESSIONS; i++)
+      {
+        if (&_sessions[i] != session)
+          continue;
+
+        _slots[i].leased    = false;
+        _slots[i].lastUsed  = millis();
+
+        if (!reusable || !_sessions[i].isConnected())
+          Close(i);
+
+        return;
+      }
+    }
+
+    /////////////////////////////////////////////
+
+    // Call often from loop(). Drives the non-blocking NOOP keepalive of idle sessions so that
+    // the server doesn't drop them, and closes the stale ones
+    void Maintain()
+    {
+      for (uint8_t i = 0; i < MAX_SESSIONS; i++)
+      {
+        if ( _slots[i].open && !_slots[i].leased && !_sessions[i].tick() )
+        {
+          FTP_LOGWARN1(F("Pool: stale session dropped, slot ="), i);
+          Close(i);
+        }
+      }
+    }
+
+    /////////////////////////////////////////////
+
+    void CloseAll()
+    {
+      for (uint8_t i = 0; i < MAX_SESSIONS; i++)
+      {
+        if (_slots[i].open && !_slots[i].leased)
+          Close(i);
+      }
+    }
+
+    /////////////////////////////////////////////
+
+    uint8_t OpenCount()
+    {
+      uint8_t count = 0;
+
+      for (uint8_t i = 0; i < MAX_SESSIONS; i++)
+      {
+        if (_slots[i].open)
+          count++;
+      }
+
+      return count;
+    }
+
+    /////////////////////////////////////////////
+
+  private:
+
+    typedef struct
+    {
+      bool          open;
+      bool          leased;
+      unsigned long lastUsed;
+    } FTPPoolSlot;
+
+    /////////////////////////////////////////////
+
+    FTPClient_Generic* Take(uint8_t slot)
+    {
+      _slots[slot].leased   = true;
+      _slots[slot].lastUsed = millis();
+
+      return &_sessions[slot];
+    }
+
+    /////////////////////////////////////////////
+
+    void Close(uint8_t slot)
+    {
+      _sessions[slot].CloseConnection();
+      _slots[slot].open = false;
+    }
+
+    /////////////////////////////////////////////
+
+    int LeastRecentlyUsed()
+    {
+      int           slot    = -1;
+      unsigned long oldest  = 0;
+
+      for (uint8_t i = 0; i < MAX_SESSIONS; i++)
+      {
+        if ( !_slots[i].open || _slots[i].leased )
+          continue;
+
+        unsigned long idle = millis() - _slots[i].lastUsed;
+
+        if ( (slot < 0) || (idle > oldest) )
+        {
+          slot    = i;
+          oldest  = idle;
+        }
+      }
+
+      return slot;
+    }
+
+    /////////////////////////////////////////////
+
+    FTPClient_Generic   _sessions[MAX_SESSIONS];
+    FTPPoolSlot         _slots[MAX_SESSIONS];
+    uint8_t             _maxOpen;
+};
+
+/////////////////////////////////////////////
+
+#endif    // FTPCLIENT_GENERIC_POOL_H
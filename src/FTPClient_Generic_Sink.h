@@ -0,0 +1,300 @@
+/****************************************************************************************************************************
+  FTPClient_Generic_Sink.h
+
+  FTP Client for Generic boards using SD, FS, etc.
+
+  Based on and modified from
+
+  1) esp32_ftpclient Library         https://github.com/ldab/ESP32_FTPClient
+
+  Built by Khoi Hoang https://github.com/khoih-prog/FTPClient_Generic
+
+  Version: 1.6.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0   K Hoang      11/05/2022 Initial porting and coding to support many more boards, using WiFi or Ethernet
+  1.1.0   K Hoang      13/05/2022 Add support to Teensy 4.1 using QNEthernet or NativeEthernet
+  1.2.0   K Hoang      14/05/2022 Add support to other FTP Servers. Fix bug
+  1.2.1   K Hoang      14/05/2022 Auto detect server response type in PASV mode
+  1.3.0   K Hoang      16/05/2022 Fix uploading issue of large files for WiFi, QNEthernet
+  1.4.0   K Hoang      05/11/2022 Add support to ESP32/ESP8266 using Ethernet W5x00 or ENC28J60
+  1.5.0   K Hoang      20/01/2023 Add support to RP2040W using `arduino-pico` core
+  1.5.0   K Hoang      20/01/2023 Add support to Ethernet W6100 using Ethernet_Generic library
+ *****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef FTPCLIENT_GENERIC_SINK_H
+#define FTPCLIENT_GENERIC_SINK_H
+
+/////////////////////////////////////////////
+
+// Flash sector (erase unit) size used by FTPFlashSink. 4KB fits ESP32/ESP8266/RP2040
+#ifndef FTP_FLASH_SECTOR_SIZE
+  #define FTP_FLASH_SECTOR_SIZE       4096
+#endif
+
+/////////////////////////////////////////////
+
+// Destination of a streamed download. Data is pushed chunk by chunk, so the whole file
+// never has to fit in RAM
+class FTPDownloadSink
+{
+  public:
+
+    // Called once before the first chunk. totalSize is 0 if unknown
+    virtual bool begin(size_t totalSize)
+    {
+      (void) totalSize;
+
+      return true;
+    }
+
+    // Must return the number of bytes consumed. Returning less than len aborts the transfer
+    virtual size_t write(const uint8_t * data, size_t len) = 0;
+
+    // Called once after the last chunk, or on error with success = false
+    virtual bool end(bool success)
+    {
+      return success;
+    }
+};
+
+/////////////////////////////////////////////
+
+// Stages the download into sector-aligned blocks and hands them to a flash backend.
+//
+// With the default single buffer, receiving stops while a sector is erased / programmed.
+// Overlap is a backend option : if program() only starts the operation and wait() blocks until it
+// is done, use BUFFERS = 2 so that the next sector is received while the previous one is written.
+// The backends in this library (FTPCallbackFlash, FTPRAMFlash) are synchronous, and gain nothing from it
+//
+// FlashBackend must provide :
+//   bool begin(size_t totalSize);
+//   bool program(uint32_t offset, const uint8_t * data, size_t len);  // erase + program, may return before done
+//   bool wait();                                                      // block until last program() is done
+//   bool end(bool success);
+template<class FlashBackend, size_t SECTOR_SIZE = FTP_FLASH_SECTOR_SIZE, uint8_t BUFFERS = 1>
+class FTPFlashSink : public FTPDownloadSink
+{
+  public:
+
+    FTPFlashSink(FlashBackend& flash) : _flash(flash)
+    {
+    }
+
+    bool begin(size_t totalSize)
+    {
+      _total    = totalSize;
+      _fill     = 0;
+      _used     = 0;
+      _offset   = 0;
+      _ok       = _flash.begin(totalSize);
+
+      return _ok;
+    }
+
+    size_t write(const uint8_t * data, size_t len)
+    {
+      size_t done = 0;
+
+      if ( (_total > 0) && (_offset + _used + len > _total) )
+      {
+        FTP_LOGERROR1(F("FTPFlashSink: more data than the expected size ="), _total);
+        _ok = false;
+
+        return 0;
+      }
+
+      while (_ok && (done < len))
+      {
+        size_t toCopy = SECTOR_SIZE - _used;
+
+        if (toCopy > len - done)
+          toCopy = len - done;
+
+        memcpy(&_buf[_fill][_used], &data[done], toCopy);
+        _used += toCopy;
+        done  += toCopy;
+
+        if (_used == SECTOR_SIZE)
+          flushSector();
+      }
+
+      return done;
+    }
+
+    bool end(bool success)
+    {
+      if (success && _ok && (_used > 0))
+        flushSector();
+
+      if (!_flash.wait())
+        _ok = false;
+
+      // Short image, the server or the caller size was wrong
+      if ( success && _ok && (_total > 0) && (_offset != _total) )
+      {
+        FTP_LOGERROR3(F("FTPFlashSink: size mismatch, written ="), _offset, F(", expected ="), _total);
+        _ok = false;
+      }
+
+      return _flash.end(success && _ok) && success && _ok;
+    }
+
+    uint32_t written()
+    {
+      return _offset;
+    }
+
+  private:
+
+    void flushSector()
+    {
+      // The other buffer may still be in flight. Wait before queuing this one so that
+      // at most one buffer is owned by the backend at any time
+      if (!_flash.wait() || !_flash.program(_offset, _buf[_fill], _used))
+      {
+        FTP_LOGERROR1(F("FTPFlashSink: program error at offset"), _offset);
+        _ok = false;
+
+        return;
+      }
+
+      // Single buffer : it is refilled right away, so the backend must be done with it
+      if ( (BUFFERS < 2) && !_flash.wait() )
+      {
+        FTP_LOGERROR1(F("FTPFlashSink: program error at offset"), _offset);
+        _ok = false;
+
+        return;
+      }
+
+      _offset += _used;
+      _used    = 0;
+
+      if (BUFFERS > 1)
+        _fill ^= 1;
+    }
+
+    FlashBackend& _flash;
+    uint8_t       _buf[(BUFFERS > 1) ? 2 : 1][SECTOR_SIZE];
+    uint8_t       _fill     = 0;
+    size_t        _total    = 0;
+    size_t        _used     = 0;
+    uint32_t      _offset   = 0;
+    bool          _ok       = false;
+};
+
+/////////////////////////////////////////////
+
+// Flash backend using user callbacks, for Teensy FlasherX-style buffers (flash_erase_block / flash_write_block),
+// STM32 HAL flash pages or any other raw flash. Offsets are relative to baseAddress
+class FTPCallbackFlash
+{
+  public:
+
+    typedef bool (*EraseCallback)(uint32_t address, size_t len);
+    typedef bool (*ProgramCallback)(uint32_t address, const uint8_t * data, size_t len);
+
+    FTPCallbackFlash(uint32_t baseAddress, size_t maxSize, EraseCallback erase, ProgramCallback program)
+      : _base(baseAddress), _maxSize(maxSize), _erase(erase), _program(program)
+    {
+    }
+
+    bool begin(size_t totalSize)
+    {
+      return (totalSize <= _maxSize);
+    }
+
+    bool program(uint32_t offset, const uint8_t * data, size_t len)
+    {
+      if (offset + len > _maxSize)
+        return false;
+
+      if ( (_erase != NULL) && !_erase(_base + offset, len) )
+        return false;
+
+      return _program(_base + offset, data, len);
+    }
+
+    bool wait()
+    {
+      return true;
+    }
+
+    bool end(bool success)
+    {
+      return success;
+    }
+
+  private:
+
+    uint32_t        _base;
+    size_t          _maxSize;
+    EraseCallback   _erase;
+    ProgramCallback _program;
+};
+
+/////////////////////////////////////////////
+
+// RAM-backed flash with NOR semantics (erase to 0xFF, program can only clear bits).
+// Useful to check a download on the host or on a board without touching the real flash
+template<size_t FLASH_SIZE, size_t SECTOR_SIZE = FTP_FLASH_SECTOR_SIZE>
+class FTPRAMFlash
+{
+  public:
+
+    bool begin(size_t totalSize)
+    {
+      memset(_mem, 0x00, FLASH_SIZE);
+
+      eraseCount    = 0;
+      programCount  = 0;
+
+      return (totalSize <= FLASH_SIZE);
+    }
+
+    bool program(uint32_t offset, const uint8_t * data, size_t len)
+    {
+      if ( (offset % SECTOR_SIZE) || (offset + len > FLASH_SIZE) )
+        return false;
+
+      memset(&_mem[offset], 0xFF, SECTOR_SIZE < FLASH_SIZE - offset ? SECTOR_SIZE : FLASH_SIZE - offset);
+      eraseCount++;
+
+      for (size_t i = 0; i < len; i++)
+        _mem[offset + i] &= data[i];
+
+      programCount++;
+
+      return true;
+    }
+
+    bool wait()
+    {
+      return true;
+    }
+
+    bool end(bool success)
+    {
+      return success;
+    }
+
+    const uint8_t * data()
+    {
+      return _mem;
+    }
+
+    uint32_t eraseCount   = 0;
+    uint32_t programCount = 0;
+
+  private:
+
+    uint8_t _mem[FLASH_SIZE];
+};
+
+/////////////////////////////////////////////
+
+#endif    // FTPCLIENT_GENERIC_SINK_H
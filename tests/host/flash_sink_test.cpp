@@ -0,0 +1,234 @@
+// Host test of FTPFlashSink (FTPClient_Generic_Sink.h) over a RAM flash. Sector alignment with one and two
+// buffers, a partial last sector, program() / wait() failures and the size checks. See run.sh
+
+#include "mock.h"
+
+#include "FTPClient_Generic_Debug.h"
+#include "FTPClient_Generic_Sink.h"
+
+/////////////////////////////////////////////
+
+#define SECTOR      16
+#define FLASH_SIZE  64
+
+// FTPRAMFlash behind an asynchronous backend : program() only queues the sector, and it is written when
+// wait() completes it. The queued buffer must not change until then. Calls are logged as
+// "B<size>" begin, "P<offset>" program, "W" wait and "E<success>" end
+class MockFlash
+{
+  public:
+
+    bool begin(size_t totalSize)
+    {
+      mock::event("B", totalSize);
+
+      pending       = NULL;
+      programCalls  = 0;
+      waitCalls     = 0;
+
+      return ram.begin(totalSize);
+    }
+
+    bool program(uint32_t offset, const uint8_t * data, size_t len)
+    {
+      mock::event("P", offset);
+
+      // The sink waits for the previous sector before queuing the next one
+      CHECK(pending == NULL);
+
+      if (programCalls++ == failProgramAt)
+        return false;
+
+      pending       = data;
+      pendingOffset = offset;
+      pendingLen    = len;
+      memcpy(snapshot, data, len);
+
+      return true;
+    }
+
+    bool wait()
+    {
+      mock::event("W");
+
+      if (pending == NULL)
+        return true;
+
+      CHECK(memcmp(pending, snapshot, pendingLen) == 0);
+
+      bool ok = ram.program(pendingOffset, pending, pendingLen) && (waitCalls++ != failWaitAt);
+
+      pending = NULL;
+
+      return ok;
+    }
+
+    bool end(bool success)
+    {
+      mock::event("E", success);
+
+      return ram.end(success);
+    }
+
+    FTPRAMFlash<FLASH_SIZE, SECTOR> ram;
+
+    int             failProgramAt = -1;
+    int             failWaitAt    = -1;
+
+  private:
+
+    const uint8_t * pending       = NULL;
+    uint32_t        pendingOffset = 0;
+    size_t          pendingLen    = 0;
+    uint8_t         snapshot[SECTOR];
+    int             programCalls  = 0;
+    int             waitCalls     = 0;
+};
+
+/////////////////////////////////////////////
+
+static uint8_t data[FLASH_SIZE + SECTOR];
+
+static void setup(MockFlash& flash)
+{
+  mock::reset();
+
+  flash.failProgramAt = -1;
+  flash.failWaitAt    = -1;
+
+  for (size_t i = 0; i < sizeof(data); i++)
+    data[i] = i * 7 + 3;
+}
+
+// Like DownloadFile() : chunks that don't line up with the sectors, end(false) after a short write
+template<class Sink>
+static bool download(Sink& sink, size_t totalSize, size_t len, size_t chunk = 7)
+{
+  if (!sink.begin(totalSize))
+    return false;
+
+  bool success = true;
+
+  for (size_t done = 0; success && (done < len); done += chunk)
+  {
+    size_t n = (len - done < chunk) ? len - done : chunk;
+
+    success = (sink.write(&data[done], n) == n);
+  }
+
+  return sink.end(success);
+}
+
+/////////////////////////////////////////////
+
+static void testSingleBuffer()
+{
+  MockFlash                                 flash;
+  FTPFlashSink<MockFlash, SECTOR>           sink(flash);
+
+  // 2.5 sectors : the last one is programmed partially, and the rest of it stays erased
+  setup(flash);
+  CHECK(download(sink, 40, 40));
+  CHECK_LOG("B40 W P0 W W P16 W W P32 W W E1");
+  CHECK(sink.written() == 40);
+  CHECK(memcmp(flash.ram.data(), data, 40) == 0);
+  CHECK( (flash.ram.data()[40] == 0xFF) && (flash.ram.data()[47] == 0xFF) && (flash.ram.data()[48] == 0x00) );
+  CHECK(flash.ram.programCount == 3);
+
+  // Unknown size
+  setup(flash);
+  CHECK(download(sink, 0, 32, 5));
+  CHECK_LOG("B0 W P0 W W P16 W W E1");
+  CHECK(memcmp(flash.ram.data(), data, 32) == 0);
+}
+
+static void testDoubleBuffer()
+{
+  MockFlash                                 flash;
+  FTPFlashSink<MockFlash, SECTOR, 2>        sink(flash);
+
+  // The next sector is received while the previous one is still queued
+  setup(flash);
+  CHECK(download(sink, 40, 40));
+  CHECK_LOG("B40 W P0 W P16 W P32 W E1");
+  CHECK(sink.written() == 40);
+  CHECK(memcmp(flash.ram.data(), data, 40) == 0);
+  CHECK(flash.ram.data()[40] == 0xFF);
+
+  // Whole sectors only, in one write
+  setup(flash);
+  CHECK(download(sink, 64, 64, 64));
+  CHECK_LOG("B64 W P0 W P16 W P32 W P48 W E1");
+  CHECK(memcmp(flash.ram.data(), data, 64) == 0);
+}
+
+static void testProgramError()
+{
+  MockFlash                                 flash;
+  FTPFlashSink<MockFlash, SECTOR>           sink(flash);
+
+  // program() refuses the second sector : the write is short and the download fails
+  setup(flash);
+  flash.failProgramAt = 1;
+  CHECK(sink.begin(40));
+  CHECK(sink.write(data, 40) == 32);
+  CHECK(!sink.end(false));
+  CHECK_LOG("B40 W P0 W W P16 W E0");
+
+  // end(true) after the error still reports it
+  setup(flash);
+  flash.failProgramAt = 1;
+  CHECK(sink.begin(40));
+  sink.write(data, 40);
+  CHECK(!sink.end(true));
+
+  // Asynchronous error of the first sector, only known by wait()
+  MockFlash                                 flash2;
+  FTPFlashSink<MockFlash, SECTOR, 2>        sink2(flash2);
+
+  setup(flash2);
+  flash2.failWaitAt = 0;
+  CHECK(!download(sink2, 40, 40));
+  CHECK(mock::log.find("P32") == std::string::npos);
+  CHECK(mock::log.substr(mock::log.size() - 2) == "E0");
+}
+
+static void testSizeMismatch()
+{
+  MockFlash                                 flash;
+  FTPFlashSink<MockFlash, SECTOR>           sink(flash);
+
+  // Larger than the flash
+  setup(flash);
+  CHECK(!sink.begin(FLASH_SIZE + 1));
+
+  // More data than announced : the chunk going past the size is refused
+  setup(flash);
+  CHECK(sink.begin(40));
+  CHECK(sink.write(data, 35) == 35);
+  CHECK(sink.write(&data[35], 10) == 0);
+  CHECK(!sink.end(false));
+
+  // Less data than announced
+  setup(flash);
+  CHECK(!download(sink, 40, 30));
+  CHECK(mock::log.substr(mock::log.size() - 2) == "E0");
+
+  // Past the end of the flash with an unknown size
+  setup(flash);
+  CHECK(!download(sink, 0, FLASH_SIZE + SECTOR));
+}
+
+/////////////////////////////////////////////
+
+int main()
+{
+  testSingleBuffer();
+  testDoubleBuffer();
+  testProgramError();
+  testSizeMismatch();
+
+  printf("flash_sink_test: %s\n", failures ? "FAILED" : "OK");
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,117 @@
+// Minimal Arduino API for the host tests. Only what the tested library files use
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define HIGH    1
+#define LOW     0
+#define OUTPUT  1
+#define INPUT   0
+
+#define F(s)    (s)
+
+unsigned long millis();
+void delay(unsigned long ms);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int  digitalRead(uint8_t pin);
+
+class Print
+{
+  public:
+    virtual size_t write(uint8_t)
+    {
+      return 1;
+    }
+
+    virtual size_t write(const uint8_t *, size_t size)
+    {
+      return size;
+    }
+
+    template<class T> size_t print(T)
+    {
+      return 0;
+    }
+
+    template<class T> size_t print(T, int)
+    {
+      return 0;
+    }
+
+    template<class T> size_t println(T)
+    {
+      return 0;
+    }
+
+    size_t println()
+    {
+      return 0;
+    }
+
+    virtual ~Print() {}
+};
+
+class Stream : public Print
+{
+};
+
+extern Print Serial;
+
+class IPAddress
+{
+  public:
+    IPAddress()
+    {
+      memset(_a, 0, 4);
+    }
+
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+    {
+      _a[0] = a;
+      _a[1] = b;
+      _a[2] = c;
+      _a[3] = d;
+    }
+
+    IPAddress(uint32_t v)
+    {
+      memcpy(_a, &v, 4);
+    }
+
+    IPAddress(const uint8_t *a)
+    {
+      memcpy(_a, a, 4);
+    }
+
+    operator uint32_t() const
+    {
+      uint32_t v;
+      memcpy(&v, _a, 4);
+
+      return v;
+    }
+
+    uint8_t operator[](int i) const
+    {
+      return _a[i];
+    }
+
+    uint8_t& operator[](int i)
+    {
+      return _a[i];
+    }
+
+    const uint8_t * raw_address() const
+    {
+      return _a;
+    }
+
+  private:
+    uint8_t _a[4];
+};
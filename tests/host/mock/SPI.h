@@ -0,0 +1,31 @@
+// SPI mock of the host tests. Transfers are appended to the test event log, see mock.h
+#pragma once
+
+#include <Arduino.h>
+
+#define SPI_MODE0   0
+#define SPI_MODE3   3
+#define MSBFIRST    1
+
+struct SPISettings
+{
+  SPISettings() {}
+  SPISettings(uint32_t, uint8_t, uint8_t) {}
+};
+
+class SPIClass
+{
+  public:
+    void begin() {}
+    void beginTransaction(SPISettings) {}
+    void endTransaction() {}
+
+    uint8_t transfer(uint8_t data);
+    void    transfer(void *buf, size_t count);
+
+#ifdef SPI_HAS_TRANSFER_BUF
+    void    transfer(const void *txbuf, void *rxbuf, size_t count);
+#endif
+};
+
+extern SPIClass SPI;
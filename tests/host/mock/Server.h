@@ -0,0 +1,9 @@
+#pragma once
+
+#include <Arduino.h>
+
+class Server : public Print
+{
+  public:
+    virtual void begin() = 0;
+};
@@ -0,0 +1,108 @@
+#include <stdio.h>
+
+#include "mock.h"
+#include "SPI.h"
+
+Print     Serial;
+SPIClass  SPI;
+
+int failures = 0;
+
+namespace mock
+{
+  std::string           log;
+  std::vector<uint8_t>  mosi;
+  uint8_t               miso    = 0;
+  unsigned long         now     = 0;
+  uint8_t               ssLevel = HIGH;
+
+  void reset()
+  {
+    log.clear();
+    mosi.clear();
+    miso    = 0;
+    ssLevel = HIGH;
+  }
+
+  void event(const char * name, long value)
+  {
+    if (!log.empty())
+      log += ' ';
+
+    log += name;
+
+    if (value >= 0)
+      log += std::to_string(value);
+  }
+}
+
+// Each call moves time on, so that timeouts expire in a bounded number of polls
+unsigned long millis()
+{
+  return mock::now++;
+}
+
+void delay(unsigned long ms)
+{
+  mock::now += ms;
+}
+
+void yield()
+{
+}
+
+void pinMode(uint8_t, uint8_t)
+{
+}
+
+// Any pin is taken as the SS pin
+void digitalWrite(uint8_t, uint8_t val)
+{
+  if (val != mock::ssLevel)
+    mock::event( (val == LOW) ? "L" : "H");
+
+  mock::ssLevel = val;
+}
+
+int digitalRead(uint8_t)
+{
+  return mock::ssLevel;
+}
+
+uint8_t SPIClass::transfer(uint8_t data)
+{
+  mock::event("B");
+  mock::mosi.push_back(data);
+
+  return mock::miso;
+}
+
+void SPIClass::transfer(void *buf, size_t count)
+{
+  mock::event("T", count);
+
+  uint8_t * p = (uint8_t *) buf;
+
+  for (size_t i = 0; i < count; i++)
+  {
+    mock::mosi.push_back(p[i]);
+    p[i] = mock::miso;
+  }
+}
+
+#ifdef SPI_HAS_TRANSFER_BUF
+
+void SPIClass::transfer(const void *txbuf, void *rxbuf, size_t count)
+{
+  mock::event("T", count);
+
+  for (size_t i = 0; i < count; i++)
+  {
+    mock::mosi.push_back( txbuf ? ((const uint8_t *) txbuf)[i] : 0);
+
+    if (rxbuf)
+      ((uint8_t *) rxbuf)[i] = mock::miso;
+  }
+}
+
+#endif
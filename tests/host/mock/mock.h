@@ -0,0 +1,49 @@
+// Event log shared by the mocks of the host tests
+#pragma once
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+
+namespace mock
+{
+  // "L" SS low, "H" SS high, "T<n>" SPI.transfer() of n bytes, "B" single-byte SPI.transfer(),
+  // plus whatever the test itself appends with event()
+  extern std::string            log;
+
+  // Bytes sent on MOSI, and the value returned on MISO
+  extern std::vector<uint8_t>   mosi;
+  extern uint8_t                miso;
+
+  extern unsigned long          now;
+  extern uint8_t                ssLevel;
+
+  void reset();
+  void event(const char * name, long value = -1);
+}
+
+#define CHECK(cond)                                                                     \
+  do                                                                                    \
+  {                                                                                     \
+    if (!(cond))                                                                        \
+    {                                                                                   \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);                   \
+      failures++;                                                                       \
+    }                                                                                   \
+  } while (0)
+
+#define CHECK_LOG(expected)                                                             \
+  do                                                                                    \
+  {                                                                                     \
+    if (mock::log != (expected))                                                        \
+    {                                                                                   \
+      printf("%s:%d: log\n  got      \"%s\"\n  expected \"%s\"\n", __FILE__, __LINE__,   \
+             mock::log.c_str(), (expected));                                            \
+      failures++;                                                                       \
+    }                                                                                   \
+  } while (0)
+
+extern int failures;
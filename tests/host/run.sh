@@ -0,0 +1,50 @@
+#!/bin/bash
+#
+# Host tests of the LibraryPatches code, built with the mocks in ./mock. Run from anywhere :
+#   tests/host/run.sh
+# CXX can be set to another compiler
+
+CXX=${CXX:-g++}
+HERE=$(cd "$(dirname "$0")" && pwd)
+ROOT=$HERE/../..
+OUT=$(mktemp -d)
+FAILED=0
+
+trap 'rm -rf "$OUT"' EXIT
+
+# run <name> <source> <flags...>
+run()
+{
+  local name=$1 src=$2
+  shift 2
+
+  if ! $CXX -std=gnu++11 -Wall -Wno-cpp -I"$HERE/mock" "$@" "$HERE/$src" "$HERE/mock/mock.cpp" -o "$OUT/test"; then
+    echo "$name: BUILD FAILED"
+    FAILED=1
+  elif ! "$OUT/test" > "$OUT/log"; then
+    echo "$name: FAILED"
+    cat "$OUT/log"
+    FAILED=1
+  else
+    echo "$name: OK"
+  fi
+}
+
+for lib in Ethernet EthernetLarge; do
+  inc="-I$ROOT/LibraryPatches/$lib/src -I$ROOT/LibraryPatches/$lib/src/utility"
+
+  run "$lib w5100_dma"                      w5100_dma_test.cpp $inc
+  run "$lib w5100_dma SPI_HAS_TRANSFER_BUF" w5100_dma_test.cpp $inc -DSPI_HAS_TRANSFER_BUF
+  run "$lib w5100_dma block frames"         w5100_dma_test.cpp $inc -DW5100_SPI_BYTEWISE_FRAMES=false
+done
+
+run "flash_sink"                           flash_sink_test.cpp -I"$ROOT/src"
+
+for lib in UIPEthernet UIPEthernet-2.0.9; do
+  inc="-I$ROOT/LibraryPatches/$lib"
+
+  run "$lib uip_chksum"                    uip_chksum_test.cpp $inc
+  run "$lib uip_chksum 8/16-bit CPU"       uip_chksum_test.cpp $inc -DUIP_CHKSUM_WIDE_WORDS=0
+done
+
+exit $FAILED
@@ -0,0 +1,139 @@
+// Host test of the word-at-a-time checksum of UIPEthernetClass::chksum() (utility/chksum.h) against the
+// original uIP byte-pair loop. Odd and even lengths, odd start addresses and the carry folds. See run.sh
+
+#include "mock.h"
+
+#include "utility/chksum.h"
+
+// uIP loop replaced by uip_chksum_words()
+static uint16_t referenceChksum(uint16_t sum, const uint8_t *data, uint16_t len)
+{
+  uint16_t t;
+  const uint8_t *dataptr   = data;
+  const uint8_t *last_byte = data + len - 1;
+
+  while (dataptr < last_byte)
+  {
+    t = (dataptr[0] << 8) + dataptr[1];
+    sum += t;
+
+    if (sum < t)
+      sum++;
+
+    dataptr += 2;
+  }
+
+  if (dataptr == last_byte)
+  {
+    t = (dataptr[0] << 8) + 0;
+    sum += t;
+
+    if (sum < t)
+      sum++;
+  }
+
+  return sum;
+}
+
+/////////////////////////////////////////////
+
+// Room for the largest len, plus the start offsets
+static uint8_t buf[65535 + 8];
+
+static const uint16_t initialSums[] = { 0x0000, 0x0001, 0x7FFF, 0x8000, 0xFFFE, 0xFFFF };
+
+static uint32_t seed = 1;
+
+static uint8_t randomByte()
+{
+  seed = seed * 1103515245 + 12345;
+
+  return seed >> 16;
+}
+
+static bool same(uint16_t sum, size_t offset, uint16_t len)
+{
+  uint16_t expected = referenceChksum(sum, &buf[offset], len);
+  uint16_t got      = uip_chksum_words(sum, &buf[offset], len);
+
+  if (got != expected)
+  {
+    printf("sum 0x%04X, offset %u, len %u : got 0x%04X, expected 0x%04X\n", sum, (unsigned) offset,
+           len, got, expected);
+
+    return false;
+  }
+
+  return true;
+}
+
+/////////////////////////////////////////////
+
+// Every length up to a few unrolled blocks, from every alignment
+static void testShortLengths()
+{
+  for (size_t i = 0; i < 256; i++)
+    buf[i] = randomByte();
+
+  for (size_t offset = 0; offset < 8; offset++)
+    for (uint16_t len = 0; len <= 80; len++)
+      for (uint16_t sum : initialSums)
+        CHECK(same(sum, offset, len));
+}
+
+static void testRandomFrames()
+{
+  for (int n = 0; n < 2000; n++)
+  {
+    size_t    offset  = randomByte() & 7;
+    uint16_t  len     = (randomByte() << 8 | randomByte()) % 1515;
+    uint16_t  sum     = randomByte() << 8 | randomByte();
+
+    for (size_t i = 0; i < len; i++)
+      buf[offset + i] = randomByte();
+
+    CHECK(same(sum, offset, len));
+  }
+}
+
+// 0xFF data makes the accumulator carry as often as possible, up to the largest len
+static void testCarryFolds()
+{
+  static const uint16_t lengths[] = { 1, 2, 3, 4, 15, 16, 17, 1500, 1501, 32768, 65534, 65535 };
+
+  memset(buf, 0xFF, sizeof(buf));
+
+  for (uint16_t len : lengths)
+    for (size_t offset = 0; offset < 2; offset++)
+      for (uint16_t sum : initialSums)
+        CHECK(same(sum, offset, len));
+
+  // Words summing to exactly 0xFFFF / 0x10000, so the last fold carries
+  memset(buf, 0, 64);
+  buf[0] = 0xFF;
+  buf[1] = 0xFE;
+  buf[3] = 0x01;
+  buf[5] = 0x01;
+
+  for (uint16_t len = 2; len <= 8; len++)
+    for (uint16_t sum : initialSums)
+      CHECK(same(sum, 0, len));
+
+  memset(buf, 0, sizeof(buf));
+
+  for (uint16_t sum : initialSums)
+    CHECK(same(sum, 1, 65535));
+}
+
+/////////////////////////////////////////////
+
+int main()
+{
+  testShortLengths();
+  testRandomFrames();
+  testCarryFolds();
+
+  printf("uip_chksum_test (%s words): %s\n", UIP_CHKSUM_WIDE_WORDS ? "32-bit" : "16-bit", failures ? "FAILED" : "OK");
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,252 @@
+// Host test of the W5x00 socket buffer transfers with and without a DMA backend (W5100Class::setDMA()).
+// Checks the order of SS, SPI and DMA calls, the threshold, the fallback to SPI.transfer() and the
+// bounded wait and abort of a stuck backend. See run.sh
+
+#include "mock.h"
+
+// chip is private, and set here instead of probing a chip with init()
+#define private public
+#include "utility/w5100.cpp"
+#undef private
+
+/////////////////////////////////////////////
+
+static bool     dmaAccept   = true;
+static int      dmaPolls    = 0;      // busy() answers before the transfer is done, -1 never done
+static int      busyLeft    = 0;
+static int      idleCount   = 0;
+
+static bool dmaStart(const uint8_t *tx, uint8_t *rx, uint16_t len)
+{
+  mock::event(tx ? "DT" : "DR", len);
+
+  // Only the data phase goes through DMA. The frame must still be open
+  CHECK(mock::ssLevel == LOW);
+  CHECK( (tx == NULL) != (rx == NULL) );
+
+  if (!dmaAccept)
+    return false;
+
+  if (tx)
+    mock::mosi.insert(mock::mosi.end(), tx, tx + len);
+  else
+    memset(rx, 0x5A, len);
+
+  busyLeft = dmaPolls;
+
+  return true;
+}
+
+static bool dmaBusy()
+{
+  CHECK(mock::ssLevel == LOW);
+
+  if (busyLeft < 0)
+    return true;
+
+  if (busyLeft == 0)
+    return false;
+
+  busyLeft--;
+
+  return true;
+}
+
+// Stops the transfer, before the frame is ended and SPI.transfer() uses the bus
+static void dmaAbort()
+{
+  mock::event("A");
+
+  CHECK(mock::ssLevel == LOW);
+  busyLeft = 0;
+}
+
+static void dmaIdle()
+{
+  idleCount++;
+}
+
+/////////////////////////////////////////////
+
+static uint8_t data[200];
+static uint8_t buf[200];
+
+static void setup(uint8_t chip)
+{
+  mock::reset();
+
+  W5100Class::chip = chip;
+  W5100Class::setDMA(NULL, NULL, NULL);
+
+  dmaAccept = true;
+  dmaPolls  = 2;
+  idleCount = 0;
+
+  for (size_t i = 0; i < sizeof(data); i++)
+    data[i] = i * 3 + 1;
+}
+
+// Data phase of a write is the tail of what was sent
+static bool sentData(uint16_t len)
+{
+  return (mock::mosi.size() >= len) && (memcmp(&mock::mosi[mock::mosi.size() - len], data, len) == 0);
+}
+
+#ifdef SPI_HAS_TRANSFER_BUF
+  #define SPI_WRITE_100   "T100"
+#else
+  // Staged in W5100_SPI_BLOCK_SIZE blocks
+  #define SPI_WRITE_100   "T32 T32 T32 T4"
+#endif
+
+/////////////////////////////////////////////
+
+static void testNoBackend()
+{
+  setup(55);
+  W5100.write(0x8000, data, 100);
+  CHECK_LOG("L T3 " SPI_WRITE_100 " H");
+  CHECK(sentData(100));
+
+  setup(55);
+  mock::miso = 0x33;
+  W5100.read(0xC000, buf, 100);
+  CHECK_LOG("L T3 T100 H");
+  CHECK( (buf[0] == 0x33) && (buf[99] == 0x33) );
+}
+
+static void testWriteW5500()
+{
+  setup(55);
+  W5100Class::setDMA(dmaStart, dmaBusy, dmaAbort, dmaIdle, 64);
+  W5100.write(0x8000, data, 100);
+  CHECK_LOG("L T3 DT100 H");
+  CHECK(sentData(100));
+  CHECK(idleCount == 2);
+
+  // No idle callback
+  setup(55);
+  W5100Class::setDMA(dmaStart, dmaBusy, dmaAbort, NULL, 64);
+  W5100.write(0x8000, data, 100);
+  CHECK_LOG("L T3 DT100 H");
+}
+
+static void testReadW5500()
+{
+  setup(55);
+  W5100Class::setDMA(dmaStart, dmaBusy, dmaAbort, dmaIdle, 64);
+  memset(buf, 0, sizeof(buf));
+  W5100.read(0xC000, buf, 100);
+  CHECK_LOG("L T3 DR100 H");
+  CHECK( (buf[0] == 0x5A) && (buf[99] == 0x5A) && (buf[100] == 0) );
+  CHECK(idleCount == 2);
+}
+
+static void testW5200()
+{
+  setup(52);
+  W5100Class::setDMA(dmaStart, dmaBusy, dmaAbort, dmaIdle, 64);
+  W5100.write(0x8000, data, 100);
+  CHECK_LOG("L T4 DT100 H");
+  CHECK(sentData(100));
+
+  setup(52);
+  W5100Class::setDMA(dmaStart, dmaBusy, dmaAbort, dmaIdle, 64);
+  W5100.read(0xC000, buf, 100);
+  CHECK_LOG("L T4 DR100 H");
+}
+
+static void testThreshold()
+{
+  setup(55);
+  W5100Class::setDMA(dmaStart, dmaBusy, dmaAbort, dmaIdle, 64);
+  W5100.write(0x8000, data, 63);
+  CHECK(mock::log.find("DT") == std::string::npos);
+  CHECK(sentData(63));
+
+  setup(55);
+  W5100Class::setDMA(dmaStart, dmaBusy, dmaAbort, dmaIdle, 64);
+  W5100.write(0x8000, data, 64);
+  CHECK_LOG("L T3 DT64 H");
+
+  // Register writes of up to 5 bytes are one SPI frame, whatever the threshold
+  setup(55);
+  W5100Class::setDMA(dmaStart, dmaBusy, dmaAbort, dmaIdle, 0);
+  W5100.write(0x8000, data, 4);
+  CHECK_LOG("L T7 H");
+
+  // The W5100 sends one 4-byte frame per byte, never through DMA
+  setup(51);
+  W5100Class::setDMA(dmaStart, dmaBusy, dmaAbort, dmaIdle, 0);
+  W5100.write(0x8000, data, 2);
+#if W5100_SPI_BYTEWISE_FRAMES
+  CHECK_LOG("L B B B B H L B B B B H");
+#else
+  CHECK_LOG("L T4 H L T4 H");
+#endif
+}
+
+static void testDeclined()
+{
+  setup(55);
+  W5100Class::setDMA(dmaStart, dmaBusy, dmaAbort, dmaIdle, 64);
+  dmaAccept = false;
+  W5100.write(0x8000, data, 100);
+  CHECK_LOG("L T3 DT100 " SPI_WRITE_100 " H");
+  CHECK(sentData(100));
+  CHECK(idleCount == 0);
+
+  setup(55);
+  W5100Class::setDMA(dmaStart, dmaBusy, dmaAbort, dmaIdle, 64);
+  dmaAccept   = false;
+  mock::miso  = 0x33;
+  W5100.read(0xC000, buf, 100);
+  CHECK_LOG("L T3 DR100 T100 H");
+  CHECK(buf[50] == 0x33);
+}
+
+static void testTimeout()
+{
+  // Stuck write : the transfer is aborted, the frame ended and sent again with SPI, and DMA is not used any more
+  setup(55);
+  W5100Class::setDMA(dmaStart, dmaBusy, dmaAbort, dmaIdle, 64);
+  dmaPolls = -1;
+  W5100.write(0x8000, data, 100);
+  CHECK_LOG("L T3 DT100 A H L T3 " SPI_WRITE_100 " H");
+  CHECK(sentData(100));
+
+  // Same header in the new frame, SPI.transfer() overwrote the first copy
+  CHECK( (mock::mosi.size() == 206) && (memcmp(&mock::mosi[0], &mock::mosi[103], 3) == 0) );
+  CHECK( (idleCount > 0) && (idleCount <= W5100_DMA_TIMEOUT_MS + 1) );
+  CHECK(W5100Class::dma_start == NULL);
+
+  mock::reset();
+  W5100.write(0x8000, data, 100);
+  CHECK_LOG("L T3 " SPI_WRITE_100 " H");
+
+  // Stuck read
+  setup(52);
+  W5100Class::setDMA(dmaStart, dmaBusy, dmaAbort, dmaIdle, 64);
+  dmaPolls    = -1;
+  mock::miso  = 0x33;
+  W5100.read(0xC000, buf, 100);
+  CHECK_LOG("L T4 DR100 A H L T4 T100 H");
+  CHECK(buf[99] == 0x33);
+}
+
+/////////////////////////////////////////////
+
+int main()
+{
+  testNoBackend();
+  testWriteW5500();
+  testReadW5500();
+  testW5200();
+  testThreshold();
+  testDeclined();
+  testTimeout();
+
+  printf("w5100_dma_test: %s\n", failures ? "FAILED" : "OK");
+
+  return failures ? 1 : 0;
+}